@@ -0,0 +1,121 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <gdkmm/general.h> // set_source_pixbuf()
+
+#include "background.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+//! Constructor
+Background::Background() :
+    alpha_(0.3),
+    started_(false)
+{
+    dispatcher_.connect(sigc::mem_fun(*this, &Background::on_loaded_));
+}
+
+//! Destructor, waits for a running decode
+Background::~Background()
+{
+    join_();
+}
+
+/*! Set the image file
+ *
+ *  The previous image is dropped.  The file is decoded when the
+ *  background is painted next.
+ */
+void Background::set_file(const std::string &file)
+{
+    if (file == file_) return;
+    join_();
+    file_= file;
+    started_= false;
+    pixbuf_.reset();
+    surface_= Cairo::RefPtr<Cairo::ImageSurface>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    loaded_.reset();
+}
+
+//! Set the opacity the image is painted with
+void Background::set_alpha(double a)
+{
+    alpha_= value_limes(a, 0.0, 1.0);
+}
+
+/*! Paint the image scaled to the canvas
+ *
+ *  \param width width of the canvas
+ *  \param height height of the canvas
+ *  \param xoff horizontal offset of the image
+ */
+void Background::paint(const Cairo::RefPtr<Cairo::Context> &cr,
+		       int width, int height, double xoff)
+{
+    if (!started_ && !file_.empty()) {
+	started_= true;
+	thread_= std::thread(&Background::load_, this, file_);
+    }
+    if (!pixbuf_ || width <= 0 || height <= 0) return;
+
+    if (!surface_ || surface_->get_width() != width ||
+	surface_->get_height() != height) {
+	Glib::RefPtr<Gdk::Pixbuf> scaled=
+	    pixbuf_->scale_simple(width, height, Gdk::INTERP_BILINEAR);
+	surface_= Cairo::ImageSurface::create(
+	    scaled->get_has_alpha() ? Cairo::FORMAT_ARGB32 : Cairo::FORMAT_RGB24,
+	    width, height);
+	Cairo::RefPtr<Cairo::Context> scr= Cairo::Context::create(surface_);
+	Gdk::Cairo::set_source_pixbuf(scr, scaled, 0.0, 0.0);
+	scr->paint();
+    }
+
+    cr->save();
+    cr->set_source(surface_, xoff, 0.0);
+    cr->paint_with_alpha(alpha_);
+    cr->restore();
+}
+
+//! Decodes the file; runs in its own thread
+void Background::load_(std::string file)
+{
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    try {
+	pixbuf= Gdk::Pixbuf::create_from_file(file);
+    }
+    catch (const Glib::Error &) {
+	return;
+    }
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	loaded_= pixbuf;
+    }
+    dispatcher_.emit();
+}
+
+//! Takes over the decoded image in the main loop
+void Background::on_loaded_()
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!loaded_) return;
+	pixbuf_= loaded_;
+	loaded_.reset();
+    }
+    surface_= Cairo::RefPtr<Cairo::ImageSurface>();
+    signal_ready();
+}
+
+//! Waits for the decoding thread
+void Background::join_()
+{
+    if (thread_.joinable())
+	thread_.join();
+}
@@ -0,0 +1,79 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_BACKGROUND_H
+#define PLOTMM_BACKGROUND_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+
+#include <glibmm/refptr.h>
+#include <glibmm/dispatcher.h>
+#include <gdkmm/pixbuf.h>
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+namespace PlotMM {
+
+    /*! @brief An image file painted behind the curves of a plot
+     *
+     *  The file is decoded once, by a thread started at the first
+     *  paint() after set_file(), so the main loop never waits for
+     *  disk I/O or decoding.  Until the image is available, paint()
+     *  draws nothing; signal_ready is emitted in the main loop when it
+     *  is.  The image scaled to the canvas is kept as a surface and
+     *  only scaled again when the size of the canvas changes.
+     */
+    class Background
+    {
+    public:
+	Background();
+	~Background();
+
+	void set_file(const std::string &file);
+	//! Return the image file
+	const std::string &file() const { return file_; }
+
+	void set_alpha(double a);
+	//! Return the opacity the image is painted with
+	double alpha() const { return alpha_; }
+
+	//! Return the decoded image (empty until it is loaded)
+	Glib::RefPtr<Gdk::Pixbuf> pixbuf() const { return pixbuf_; }
+
+	void paint(const Cairo::RefPtr<Cairo::Context> &cr,
+		   int width, int height, double xoff = 0.0);
+
+	//! Emitted in the main loop when the image has been decoded
+	sigc::signal0<void> signal_ready;
+
+    private:
+	Background(const Background &);
+	Background &operator=(const Background &);
+
+	void load_(std::string file);
+	void on_loaded_();
+	void join_();
+
+	std::string file_;
+	double alpha_;
+	bool started_;
+
+	Glib::RefPtr<Gdk::Pixbuf> pixbuf_;
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+
+	std::thread thread_;
+	std::mutex mutex_;
+	Glib::RefPtr<Gdk::Pixbuf> loaded_;
+	Glib::Dispatcher dispatcher_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include "colormap.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+// counts up to this value are shaded through a table
+static const uint32_t shade_max = 4095;
+
+static const double heat_stops[][4] = {
+    { 0.0, 0.0, 1.0, 0.0 },
+    { 0.0, 0.0, 1.0, 1.0 },
+    { 0.0, 1.0, 1.0, 1.0 },
+    { 1.0, 1.0, 0.0, 1.0 },
+    { 1.0, 0.0, 0.0, 1.0 }
+};
+
+//! Construct the default colormap
+ColorMap::ColorMap()
+{
+    set_stops_(heat_stops, sizeof(heat_stops)/sizeof(heat_stops[0]));
+}
+
+/*! Set the color stops of the map
+ *
+ *  The stops are spread evenly over the table, the first one being
+ *  used for index 0 and the last one for index Size-1.  At least two
+ *  stops must be given, otherwise the map is left unchanged.
+ */
+void ColorMap::set_stops(const std::vector<Gdk::RGBA> &stops)
+{
+    if (stops.size() < 2) return;
+    std::vector<double> buffer(stops.size() * 4);
+    for (unsigned int i= 0; i < stops.size(); ++i) {
+	buffer[4*i]= stops[i].get_red();
+	buffer[4*i+1]= stops[i].get_green();
+	buffer[4*i+2]= stops[i].get_blue();
+	buffer[4*i+3]= stops[i].get_alpha();
+    }
+    set_stops_(reinterpret_cast<const double (*)[4]>(&buffer[0]),
+	       stops.size());
+}
+
+/*! Return the pixel for a fraction f of the table
+ *
+ *  f is limited to [0,1].
+ */
+uint32_t ColorMap::pixel(double f) const
+{
+    int i= int(f * (Size - 1) + 0.5);
+    return lut_[value_limes(i, 0, int(Size - 1))];
+}
+
+/*! Shade a grid of counts into ARGB32 pixels
+ *
+ *  Count 0 is fully transparent, maxCount gets the last color of the
+ *  map and counts in between are spread on a logarithmic scale.
+ *
+ *  \param counts cols x rows counts, row by row
+ *  \param maxCount highest value in counts
+ *  \param data pixel data of a FORMAT_ARGB32 image surface
+ *  \param stride row stride of data in bytes
+ */
+void ColorMap::shade(const uint32_t *counts, int cols, int rows,
+		     uint32_t maxCount, unsigned char *data, int stride) const
+{
+    const double norm= maxCount > 0 ? 1.0 / log1p(double(maxCount)) : 0.0;
+    const uint32_t nshade= MIN(maxCount, shade_max) + 1;
+    std::vector<uint32_t> table(nshade);
+    table[0]= 0;
+    for (uint32_t c= 1; c < nshade; ++c)
+	table[c]= pixel(log1p(double(c)) * norm);
+
+    for (int r= 0; r < rows; ++r) {
+	uint32_t *row= reinterpret_cast<uint32_t *>(data + r * stride);
+	const uint32_t *cnt= counts + r * cols;
+	for (int c= 0; c < cols; ++c) {
+	    const uint32_t n= cnt[c];
+	    row[c]= n < nshade ? table[n] : pixel(log1p(double(n)) * norm);
+	}
+    }
+}
+
+//! Fill the table by interpolating n rgba stops
+void ColorMap::set_stops_(const double (*rgba)[4], int n)
+{
+    for (int i= 0; i < Size; ++i) {
+	const double pos= double(i) / (Size - 1) * (n - 1);
+	const int k= MIN(int(pos), n - 2);
+	const double t= pos - k;
+	double c[4];
+	for (int j= 0; j < 4; ++j)
+	    c[j]= rgba[k][j] + (rgba[k+1][j] - rgba[k][j]) * t;
+	// Cairo expects premultiplied alpha
+	const uint32_t a= uint32_t(c[3] * 255.0 + 0.5);
+	const uint32_t r= uint32_t(c[0] * c[3] * 255.0 + 0.5);
+	const uint32_t g= uint32_t(c[1] * c[3] * 255.0 + 0.5);
+	const uint32_t b= uint32_t(c[2] * c[3] * 255.0 + 0.5);
+	lut_[i]= (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
@@ -0,0 +1,56 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_COLORMAP_H
+#define PLOTMM_COLORMAP_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <gdkmm/rgba.h>
+
+namespace PlotMM {
+
+    /*! @brief A precomputed color lookup table
+     *
+     *  ColorMap holds ColorMap::Size colors interpolated between a
+     *  number of evenly spaced color stops.  The colors are stored as
+     *  premultiplied ARGB32 pixels and can be written directly into
+     *  the data of a Cairo::ImageSurface.
+     *
+     *  By default the map runs from transparent over blue, cyan and
+     *  yellow to red.
+     *
+     *  shade() maps a grid of hit counts on a logarithmic scale, as
+     *  used by the density styles of Curve and Plot.
+     */
+    class ColorMap
+    {
+    public:
+	ColorMap();
+
+	void set_stops(const std::vector<Gdk::RGBA> &stops);
+
+	//! Return the pixel for table index i (0 <= i < Size)
+	uint32_t pixel(int i) const { return lut_[i]; }
+	uint32_t pixel(double f) const;
+
+	void shade(const uint32_t *counts, int cols, int rows,
+		   uint32_t maxCount, unsigned char *data, int stride) const;
+
+	enum { Size = 256 };
+
+    private:
+	void set_stops_(const double (*rgba)[4], int n);
+
+	uint32_t lut_[Size];
+    };
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <gtkmmconfig.h>
 #include <assert.h>
+#include <atomic>
 #include <sigc++/sigc++.h>
 
 //#if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION >= 4)
@@ -26,6 +27,10 @@ namespace PlotMM {
 #endif
     {};
 
+    // the reference count belongs to the object, not to its value
+    ObjectBase &operator=(const ObjectBase &a)
+      { sigc::trackable::operator=(a); return *this; }
+
     virtual ~ObjectBase() {
 #ifdef DEBUG
       is_to_be_deleted();
@@ -47,7 +52,8 @@ namespace PlotMM {
     };
 
   private:
-    mutable unsigned int _counter;
+    // atomic so that curves may be shared with rendering threads
+    mutable std::atomic<unsigned int> _counter;
 #ifdef DEBUG
     void is_valid()         const {assert (_counter>0); assert(_magic==1234);};
     void is_to_be_deleted() const {assert (_counter==0); assert(_magic==1234);};
@@ -7,6 +7,11 @@
  *****************************************************************************/
 /* ported from qwt */
 
+#include <algorithm>
+#include <typeinfo>
+#include <math.h>
+#include <stdint.h>
+
 #include <glibmm/refptr.h>
 
 //#include <gdkmm/drawable.h>
@@ -14,24 +19,60 @@
 #include "doubleintmap.h"
 #include  "curve.h"
 #include "paint.h"
+#include "polyline.h"
+#include "raster.h"
 #include "supplemental.h"
 
 using namespace PlotMM;
 
+// vertices per path stroked by the line and step styles
+static const int stroke_chunk= 1024;
+
 //! Initialize data members
 void Curve::init(const Glib::ustring &title)
 {
     enabled_= true;
+    maxSize_= 0;
+    discarded_= 0;
+    serial_= 0;
+    rewrites_= 0;
+    dataSize_= 0;
+    xSorted_= true;
+    sketched_= 0;
+    logXValid_= logYValid_= 0;
+    logRunsKey_= logRunsValid_= 0;
     baseline_ = 0.0;
     options_ = CURVE_AUTO;
     title_ = title;
     cStyle_= CURVE_LINES;
+    aliased_= false;
     paint_= Glib::RefPtr<Paint> (new Paint);
     symbol_= Glib::RefPtr<Symbol> (new Symbol);
 }
 
 //! Copy the contents of a curve into another curve
 void Curve::copy(const Curve &c)
+{
+    copy_style_(c);
+    x_= c.x_;
+    y_= c.y_;
+    discarded_= c.discarded_;
+    rewrites_= c.rewrites_;
+    dataSize_= c.dataSize_;
+    yIndex_= c.yIndex_;
+    xSorted_= c.xSorted_;
+    runs_= c.runs_;
+    logXValid_= logYValid_= 0;
+    logRunsKey_= logRunsValid_= 0;
+    logRuns_.clear();
+    ySketch_.clear();
+    sketched_= 0;
+    sketch_y_();
+    density_.reset();
+}
+
+//! Copy everything but the data of a curve into another curve
+void Curve::copy_style_(const Curve &c)
 {
     enabled_= c.enabled_;
     baseline_ = c.baseline_;
@@ -39,10 +80,9 @@ void Curve::copy(const Curve &c)
     title_ = c.title_;
     paint_ = c.paint_;
     cStyle_ = c.cStyle_;
-
+    aliased_= c.aliased_;
     options_ = c.options_;
-    x_= c.x_;
-    y_= c.y_;
+    maxSize_= c.maxSize_;
 }
 
 //! Destructor
@@ -78,6 +118,132 @@ const Curve& Curve::operator=(const Curve &c)
     return *this;
 }
 
+/*!
+  \brief Return a copy of the curve to be drawn by another thread
+
+  The copy has its own paint() and symbol(), so they can be changed
+  while the copy is drawn.  Derived classes which keep state between calls of draw() return an
+  empty pointer; such curves can only be drawn by the main thread.
+*/
+Glib::RefPtr<Curve> Curve::clone() const
+{
+    Glib::RefPtr<Curve> c(new Curve(*this));
+    c->detach_style_();
+    return c;
+}
+
+//! Give the curve a Paint and a Symbol of its own
+void Curve::detach_style_()
+{
+    paint_= Glib::RefPtr<Paint>(new Paint(*paint_));
+    symbol_= Glib::RefPtr<Symbol>(new Symbol(*symbol_));
+}
+
+/*!
+  \brief Find the samples which can show between two pixel columns
+
+  This is used to draw a curve in vertical strips, e.g. into tiles,
+  without walking all samples for every strip.  If the x values are
+  ascending, the range is found by bisection and extended by one
+  sample on either side, so that lines and steps crossing the edges
+  are drawn.  The columns are widened by the size of dots and
+  symbols.  Otherwise, and for horizontal sticks, all samples are
+  returned.
+
+  \param xMap x map the curve is drawn with
+  \param px1 first pixel column
+  \param px2 last pixel column
+  \param from returns the index of the first sample
+  \param to returns the index of the last sample; to < from if there
+         are no samples
+*/
+void Curve::index_range(const DoubleIntMap &xMap, int px1, int px2,
+			int &from, int &to) const
+{
+    from= 0;
+    to= data_size() - 1;
+    if (!xSorted_ || to < 0 || xMap.i1() == xMap.i2() ||
+	(cStyle_ == CURVE_STICKS && (options_ & CURVE_X_FY)))
+	return;
+
+    const int margin= 8 + (symbol_->style() != SYMBOL_NONE ?
+			   MAX(symbol_->size(), symbol_->size_aux()) : 0);
+    double x1= xMap.inv_transform(MIN(px1, px2) - margin);
+    double x2= xMap.inv_transform(MAX(px1, px2) + margin);
+    if (x1 > x2) std::swap(x1, x2);
+    int lo, hi;
+    x_bounds_(x1, x2, lo, hi);
+    from= MAX(lo - 1, 0);
+    to= MIN(hi, to);
+}
+
+/*! Bisect ascending values which may contain NaN
+
+  \return the first index from which on all values which are not NaN
+          are >= v, or > v if upper is true
+*/
+static int bisect_x(const std::vector<double> &x, double v, bool upper)
+{
+    int lo= 0, hi= x.size();
+    while (lo < hi) {
+	const int mid= lo + (hi - lo) / 2;
+	int m= mid;
+	while (m < hi && x[m] != x[m]) ++m;
+	if (m < hi && (upper ? !(v < x[m]) : x[m] < v))
+	    lo= m + 1;
+	else
+	    hi= mid;
+    }
+    return lo;
+}
+
+//! Bisect the ascending x values: [lo, hi) holds those in [x1, x2]
+void Curve::x_bounds_(double x1, double x2, int &lo, int &hi) const
+{
+    lo= bisect_x(x_, x1, false);
+    hi= bisect_x(x_, x2, true);
+}
+
+/*!
+  \brief Bring a copy made by clone() up to date with this curve
+
+  If only samples have been appended since c was made or updated, the
+  new samples are appended to c and its indices are extended, instead
+  of copying all data again.  c must not be drawn meanwhile.  Derived
+  classes with data of their own return false unless they override
+  this.
+
+  \return false if c could not be updated; it has to be cloned anew
+*/
+bool Curve::update_copy(Curve &c) const
+{
+    if (typeid(c) != typeid(Curve) || typeid(*this) != typeid(Curve))
+        return false;
+    if (c.rewrites_ != rewrites_ || c.discarded_ != discarded_ ||
+        c.data_size() > data_size())
+        return false;
+
+    c.copy_style_(*this);
+    c.detach_style_();
+    const int first= c.data_size();
+    c.x_.insert(c.x_.end(), x_.begin() + first, x_.end());
+    c.y_.insert(c.y_.end(), y_.begin() + first, y_.end());
+    c.data_changed(first);
+    c.serial_= serial_;
+    return true;
+}
+
+/*!
+  \brief Query if draw() may be called by several threads at once
+
+  This is the case unless draw() updates cached state of the curve,
+  like the grid of the CURVE_DENSITY style.
+*/
+bool Curve::concurrent_draw() const
+{
+    return cStyle_ != CURVE_DENSITY;
+}
+
 /*!
   \brief Set the curve's drawing style
 
@@ -96,6 +262,10 @@ const Curve& Curve::operator=(const Curve &c)
   <dt>Curves::CURVE_DOTS</dt>
   <dd>Draw dots at the locations of the data points. Note:
       This is different from a dotted line (see set_pen()).</dd>
+  <dt>CURVE_DENSITY</dt>
+  <dd>Draw the number of data points per pixel cell as a heatmap.
+      Meant for scatter data with millions of points.
+      \sa Curve::density(), DensityGrid</dd>
   <dt>Curve::UserCurve ...</dt>
   <dd>Styles >= Curve::UserCurve are reserved for derived
       classes of Curve that overload Curve::draw() with
@@ -164,6 +334,8 @@ void Curve::set_data(const double *xData, const double *yData, int size)
 {
     vector_from_c(x_,xData,size);
     vector_from_c(y_,yData,size);
+    discarded_= 0;
+    data_changed(0);
     curve_changed();
 }
 
@@ -181,6 +353,8 @@ void Curve::set_data(const std::vector<double> &xData,
 
     x_= xData;
     y_= yData;
+    discarded_= 0;
+    data_changed(0);
     curve_changed();
 }
 
@@ -200,9 +374,62 @@ void Curve::set_data(const Glib::ArrayHandle<DoublePoint> &data)
 	x_.push_back((*daPnt).get_x());
 	y_.push_back((*daPnt).get_y());
     }
+    discarded_= 0;
+    data_changed(0);
     curve_changed();
 }
 
+/*!
+  \brief Append x- and y-values to the data of the curve
+
+  Contrary to set_data(), the existing data are kept.  Caches derived
+  from the data, like the counts of the CURVE_DENSITY style, are
+  extended instead of being rebuilt.
+
+  If a maximum size is set, the oldest samples are dropped once the
+  data grow past it.  Dropping shifts the indices of all remaining
+  samples and is reported to data_changed() with first = 0.
+
+  \param xData pointer to x values
+  \param yData pointer to y values
+  \param size number of values to append
+  \sa Curve::set_max_size
+*/
+void Curve::append_data(const double *xData, const double *yData, int size)
+{
+    if (size <= 0) return;
+    int first= data_size();
+    x_.insert(x_.end(), xData, xData + size);
+    y_.insert(y_.end(), yData, yData + size);
+
+    // drop in blocks of at least half the maximum size so that the
+    // cost of moving the remaining samples is amortized
+    if (maxSize_ > 0 && data_size() > maxSize_ + MAX(maxSize_/2, 1024)) {
+	const int n= data_size() - maxSize_;
+	x_.erase(x_.begin(), x_.begin() + n);
+	y_.erase(y_.begin(), y_.begin() + n);
+	discarded_+= n;
+	first= 0;
+    }
+    data_changed(first);
+    curve_changed();
+}
+
+/*!
+  \brief Limit the number of samples kept by append_data()
+
+  With a limit set, the curve behaves like a ring buffer for streamed
+  data: append_data() drops the oldest samples when needed.  The total
+  number of dropped samples is returned by discarded(), so that
+  absolute sample positions can be tracked across drops.
+
+  \param n maximum number of samples, 0 for no limit
+*/
+void Curve::set_max_size(int n)
+{
+    maxSize_= MAX(0, n);
+}
+
 /*!
   \brief Assign a title to a curve
   \param title new title
@@ -213,6 +440,17 @@ void Curve::set_title(const Glib::ustring &title)
     curve_changed();
 }
 
+/*!
+    \brief Draw lines, sticks and dots as aliased pixels
+    \sa Curve::draw_raster_
+*/
+void Curve::set_aliased(bool b)
+{
+    if (b == aliased_) return;
+    aliased_= b;
+    curve_changed();
+}
+
 /*!
     \brief Return the title.
     \sa Curve::set_title
@@ -222,6 +460,116 @@ const Glib::ustring &Curve::title() const
     return title_;
 }
 
+/*!
+  \brief Find the extrema of the y values of the samples within an x range
+
+  If the x values are in ascending order, the samples in the range are
+  found by bisection and their extrema are taken from an index which is
+  maintained by data_changed(), so the cost is O(log n).  Otherwise all
+  samples are scanned.
+
+  \param x1 lower bound of the x range
+  \param x2 upper bound of the x range
+  \param ymin minimum of the y values found
+  \param ymax maximum of the y values found
+  \return false if no sample with a y value other than NaN is in range
+*/
+bool Curve::y_extent(double x1, double x2, double &ymin, double &ymax) const
+{
+    if (x1 > x2) std::swap(x1, x2);
+    if (xSorted_) {
+	int from, to;
+	x_bounds_(x1, x2, from, to);
+	return yIndex_.extrema(y_data(), from, to-1, ymin, ymax);
+    }
+
+    bool found= false;
+    for (int i= 0; i < data_size(); ++i) {
+	if (!(x_[i] >= x1 && x_[i] <= x2) || y_[i] != y_[i]) continue;
+	if (!found) {
+	    ymin= ymax= y_[i];
+	    found= true;
+	} else {
+	    ymin= MIN(ymin, y_[i]);
+	    ymax= MAX(ymax, y_[i]);
+	}
+    }
+    return found;
+}
+
+/*!
+  \brief Return the x values as raw values of a map
+
+  For linear maps these are x_data(), for logarithmic maps the decadic
+  logarithms of the x values, which are computed when first needed and
+  kept until the data change.  Values before the first changed sample
+  are kept as well, so appending only computes the logarithms of the
+  new samples.  Non-positive values are clamped once here.  The values
+  can be mapped with DoubleIntMap::raw_transform().
+*/
+const double *Curve::x_column(const DoubleIntMap &m) const
+{
+    if (!m.logarithmic()) return x_data();
+    return log_column_(x_, logX_, logXValid_);
+}
+
+/*!
+  \brief Return the y values as raw values of a map
+  \sa x_column
+*/
+const double *Curve::y_column(const DoubleIntMap &m) const
+{
+    if (!m.logarithmic()) return y_data();
+    return log_column_(y_, logY_, logYValid_);
+}
+
+/*!
+  \brief Bring a column of logarithms up to date
+  Locked, since tiles of a curve may be drawn by several threads.
+*/
+const double *Curve::log_column_(const std::vector<double> &v,
+				 std::vector<double> &col, int &valid) const
+{
+    std::lock_guard<std::mutex> lock(logMutex_);
+    const int n= v.size();
+    if (valid < n) {
+	col.resize(n);
+	for (int i= valid; i < n; ++i)
+	    col[i]= DoubleIntMap::raw_value(v[i], true);
+    }
+    valid= n;
+    return n ? &col[0] : 0;
+}
+
+/*!
+  \brief Find approximate quantiles of the y values
+
+  The quantiles are taken from a QuantileSketch of the y values,
+  which data_changed() keeps up to date: appended samples are added
+  to it, replaced data are sketched anew.  Unlike the bounding
+  rectangle, the quantiles are not stretched by a few outliers.
+
+  \param q1 lower quantile, e.g. 0.005
+  \param q2 upper quantile, e.g. 0.995
+  \param y1 value of the lower quantile
+  \param y2 value of the upper quantile
+  \return false if there are no y values other than NaN
+*/
+bool Curve::y_quantiles(double q1, double q2, double &y1, double &y2) const
+{
+    if (!ySketch_.count()) return false;
+    y1= ySketch_.quantile(q1);
+    y2= ySketch_.quantile(q2);
+    return true;
+}
+
+//! Add the y values not yet in the quantile sketch to it
+void Curve::sketch_y_()
+{
+    for (; sketched_ < data_size(); ++sketched_)
+	ySketch_.insert(y_[sketched_]);
+}
+
 /*!
   Returns the bounding rectangle of the curve data. If there is
   no bounding rect, like for empty data the rectangle is invalid:
@@ -230,31 +578,72 @@ const Glib::ustring &Curve::title() const
 
 DoubleRect Curve::bounding_rect() const
 {
-    if ( (x_.size()==0) || (x_.size()!=y_.size()) )
+    if ( runs_.empty() || (x_.size()!=y_.size()) )
         return DoubleRect(1.0, -1.0, 1.0, -1.0); // invalid
 
-    const size_t sz = x_.size();
-
+    // samples in gaps are NaN and skipped with them
     double minX, maxX, minY, maxY;
-    std::vector<double>::const_iterator xIt = x_.begin();
-    std::vector<double>::const_iterator yIt = y_.begin();
-    std::vector<double>::const_iterator end = x_.begin() + sz;
-    minX = maxX = *xIt++;
-    minY = maxY = *yIt++;
+    minX = maxX = x_[runs_[0].first];
+    minY = maxY = y_[runs_[0].first];
 
-    while ( xIt < end )
+    for (Runs::const_iterator r = runs_.begin(); r != runs_.end(); ++r)
     {
-        const double xv = *xIt++;
-        if ( xv < minX )
-            minX = xv;
-        if ( xv > maxX )
-            maxX = xv;
-
-        const double yv = *yIt++;
-        if ( yv < minY )
-            minY = yv;
-        if ( yv > maxY )
-            maxY = yv;
+        for (int i = r->first; i <= r->second; ++i)
+        {
+            const double xv = x_[i];
+            if ( xv < minX )
+                minX = xv;
+            if ( xv > maxX )
+                maxX = xv;
+
+            const double yv = y_[i];
+            if ( yv < minY )
+                minY = yv;
+            if ( yv > maxY )
+                maxY = yv;
+        }
+    }
+    return DoubleRect(minX, maxX, minY, maxY);
+}
+
+/*!
+  \brief Return the bounding rectangle of the samples a plot can show
+
+  On logarithmic axes, samples with a non-positive value on that axis
+  are not drawn and are left out here as well, so a single zero does
+  not stretch an autoscaled axis down to its limit.
+
+  \param logX true if the x axis is logarithmic
+  \param logY true if the y axis is logarithmic
+  \return bounding_rect() if neither axis is logarithmic; an invalid
+          rectangle if no sample can be shown
+*/
+DoubleRect Curve::bounding_rect(bool logX, bool logY) const
+{
+    if (!logX && !logY)
+        return bounding_rect();
+
+    bool found = false;
+    double minX = 1.0, maxX = -1.0, minY = 1.0, maxY = -1.0;
+    for (Runs::const_iterator r = runs_.begin(); r != runs_.end(); ++r)
+    {
+        for (int i = r->first; i <= r->second; ++i)
+        {
+            const double xv = x_[i], yv = y_[i];
+            if ((logX && !(xv > 0.0)) || (logY && !(yv > 0.0)))
+                continue;
+            if (!found)
+            {
+                minX = maxX = xv;
+                minY = maxY = yv;
+                found = true;
+                continue;
+            }
+            minX = MIN(minX, xv);
+            maxX = MAX(maxX, xv);
+            minY = MIN(minY, yv);
+            maxY = MAX(maxY, yv);
+        }
     }
     return DoubleRect(minX, maxX, minY, maxY);
 }
@@ -297,13 +686,15 @@ void Curve::draw(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk
     if ( data_size() <= 0 )
         return;
 
-    int winx, winy, winw, winh;
-    painter->get_geometry(winx, winy, winw, winh);
-
     if (to < 0)
         to = data_size() - 1;
     if ( verify_range(from, to) > 0 ) {
-        draw_curve_(cr, painter, cStyle_, xMap, yMap, from, to);
+        if (aliased_ && !paint()->filled() &&
+            (cStyle_ == CURVE_LINES || cStyle_ == CURVE_STICKS ||
+             cStyle_ == CURVE_DOTS))
+            draw_raster_(cr, xMap, yMap, from, to);
+        else
+            draw_curve_(cr, painter, cStyle_, xMap, yMap, from, to);
 
         if (symbol_->style() != SYMBOL_NONE) {
             draw_symbols_(cr, painter, symbol_, xMap, yMap, from, to);
@@ -347,6 +738,9 @@ void Curve::draw_curve_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Ref
         case CURVE_DOTS:
             draw_dots_(cr, painter, xMap, yMap, from, to);
             break;
+        case CURVE_DENSITY:
+            draw_density_(cr, painter, xMap, yMap, from, to);
+            break;
         default:
             break;
     }
@@ -365,26 +759,25 @@ void Curve::draw_curve_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Ref
 void Curve::draw_lines_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
     const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
 {
-    int xi, yi;
-    //std::vector<Gdk::Point> polyline;
-
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
     paint()->set_cr_to_pen(cr);
     cr->set_line_width(1.0);
 
-    xi = xMap.transform(x(from));
-    yi = xMap.transform(y(from));
-
-    cr->move_to(xMap.transform(x(from)),yMap.transform(y(from)));
-    for (int i = from; i <= to; i++)
+    // clipped to the visible canvas before the vertices are rounded
+    PolylineSink sink(cr, options_ & CURVE_X_FY);
+    sink.clip_to_context(cr->get_line_width());
+    sink.set_chunk(stroke_chunk);
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-
-// transform converts a double to int or a log conversion to int.
-        xi = xMap.transform(x(i));
-        yi = yMap.transform(y(i));
-        //polyline.push_back(Gdk::Point(xi, yi));
-        cr->line_to(xi,yi);
-
+        const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+        sink.move_to(xMap.raw_x_transform(xs[r0]), yMap.raw_x_transform(ys[r0]));
+        for (int i = r0+1; i <= r1; i++)
+            sink.line_to(xMap.raw_x_transform(xs[i]), yMap.raw_x_transform(ys[i]));
     }
+    sink.flush();
 
     cr->stroke();
 
@@ -393,29 +786,25 @@ void Curve::draw_lines_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Ref
 
 //  Not sure why you would ever want the following
     if ( paint()->filled() )
-
     {
+        // every run is filled down to the baseline on its own, so
+        // gaps stay empty
+        double cx1, cy1, cx2, cy2;
+        cr->get_clip_extents(cx1, cy1, cx2, cy2);
+        const double yb= value_limes(yMap.x_transform(baseline_),
+                                     cy1 - 1.0, cy2 + 1.0);
         paint()->set_cr_to_brush(cr);
-        cr->move_to(xMap.transform(x(from)),yMap.transform(y(from)));
-
-        for (int i = from+1; i <= to; i++)
+        for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
         {
-    // transform converts a double to int or a log conversion to int.
-            int xi = xMap.transform(x(i));
-            int yi = yMap.transform(y(i));
-
-            //polyline.push_back(Gdk::Point(xi, yi));
-            cr->line_to(xi,yi);
+            const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+            cr->move_to(xMap.raw_transform(xs[r0]), yb);
+            for (int i = r0; i <= r1; i++)
+                cr->line_to(xMap.raw_transform(xs[i]), yMap.raw_transform(ys[i]));
+            cr->line_to(xMap.raw_transform(xs[r1]), yb);
+            cr->close_path();
         }
-        // what is desired here is to fill everything below the curve so...
-        cr->line_to(xMap.transform(x(to)),yMap.transform(y(0)));
-        cr->line_to(xMap.transform(y(from)),yMap.transform(y(0)));
-        cr->close_path();
         cr->fill();
-
-
     }
-
 }
 
 /*!
@@ -433,28 +822,33 @@ void Curve::draw_sticks_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Re
     paint()->set_cr_to_pen(cr);
     cr->set_line_width(1.0);
 
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
     int x0 = xMap.transform(baseline_);
     int y0 = yMap.transform(baseline_);
 
-    for (int i = from; i <= to; i++)
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-        int xi = xMap.transform(x(i));
-        int yi = yMap.transform(y(i));
-
-        if (options_ & CURVE_X_FY)
+        for (int i = MAX(r->first, from); i <= MIN(r->second, to); i++)
         {
-            cr->move_to(x0, yi);
-            cr->line_to(xi, yi);
-            cr->stroke();
+            int xi = xMap.raw_transform(xs[i]);
+            int yi = yMap.raw_transform(ys[i]);
 
+            if (options_ & CURVE_X_FY)
+            {
+                cr->move_to(x0, yi);
+                cr->line_to(xi, yi);
+                cr->stroke();
+            }
+            else
+            {
+                cr->move_to(xi, y0);
+                cr->line_to(xi, yi);
+                cr->stroke();
+            }
         }
-        else
-         {
-            cr->move_to(xi, y0);
-            cr->line_to(xi, yi);
-            cr->stroke();
-
-         }
     }
 }
 
@@ -478,16 +872,20 @@ void Curve::draw_dots_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefP
     paint()->set_cr_to_pen(cr);
     cr->set_line_width(8);
     cr->set_line_cap(Cairo::LINE_CAP_ROUND);
-    for (int i = from; i <= to; i++)
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-        int xi = xMap.transform(x(i));
-        int yi = yMap.transform(y(i));
-
-
-        cr->move_to(xi, yi);
-        cr->line_to(xi, yi);
-        //painter->draw_point(paint()->pen(painter), xi, yi);
+        for (int i = MAX(r->first, from); i <= MIN(r->second, to); i++)
+        {
+            int xi = xMap.raw_transform(xs[i]);
+            int yi = yMap.raw_transform(ys[i]);
 
+            cr->move_to(xi, yi);
+            cr->line_to(xi, yi);
+        }
     }
 
     cr->stroke();
@@ -497,52 +895,166 @@ void Curve::draw_dots_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefP
 }
 
 /*!
-  \brief Draw step function
+  \brief Draw lines, sticks or dots as aliased pixels
+
+  Instead of building a Cairo path, the pixels are written straight
+  into an image the size of the clip, which is then painted onto cr
+  like any other layer.  Lines and sticks are 1 pixel wide Bresenham
+  lines, dots are filled discs of the size CURVE_DOTS uses.  This is
+  much faster for curves with many samples, at the price of jagged
+  edges.  The image is local to the call, so a curve can still be
+  drawn into several tiles at once.
+
+  \param xMap x map
+  \param yMap y map
+  \param from index of the first point to be painted
+  \param to index of the last point to be painted
+  \sa Curve::set_aliased, raster_line, raster_disc
+*/
+void Curve::draw_raster_(const Cairo::RefPtr<Cairo::Context> &cr,
+    const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
+{
+    double cx1, cy1, cx2, cy2;
+    cr->get_clip_extents(cx1, cy1, cx2, cy2);
+    const int ox= int(floor(cx1)), oy= int(floor(cy1));
+    const int w= int(ceil(cx2)) - ox, h= int(ceil(cy2)) - oy;
+    if (w <= 0 || h <= 0) return;
+
+    Cairo::RefPtr<Cairo::ImageSurface> image=
+        Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w, h);
+    image->flush();
+    unsigned char *data= image->get_data();
+    const int stride= image->get_stride();
+
+    // ARGB32 is premultiplied; a pixel hit twice is still set once,
+    // like a stroked path
+    const Gdk::RGBA &c= paint()->pen_color();
+    const double a= value_limes(c.get_alpha(), 0.0, 1.0);
+    const uint32_t pixel= (uint32_t(ROUND(a * 255)) << 24) |
+        (uint32_t(ROUND(value_limes(c.get_red(), 0.0, 1.0) * a * 255)) << 16) |
+        (uint32_t(ROUND(value_limes(c.get_green(), 0.0, 1.0) * a * 255)) << 8) |
+        uint32_t(ROUND(value_limes(c.get_blue(), 0.0, 1.0) * a * 255));
+    auto plot= [data, stride, pixel](int x, int y) {
+        reinterpret_cast<uint32_t *>(data + y * stride)[x]= pixel;
+    };
+
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    const double bx= xMap.x_transform(baseline_) - ox;
+    const double by= yMap.x_transform(baseline_) - oy;
+
+    // segments are clipped to the image before they are rounded
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
+    {
+        const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+        double xp= 0.0, yp= 0.0;
+        for (int i = r0; i <= r1; i++)
+        {
+            const double xi= xMap.raw_x_transform(xs[i]) - ox;
+            const double yi= yMap.raw_x_transform(ys[i]) - oy;
+            switch (cStyle_)
+            {
+                case CURVE_LINES:
+                    if (i == r0)
+                        raster_segment(xi, yi, xi, yi, w, h, plot);
+                    else
+                        raster_segment(xp, yp, xi, yi, w, h, plot);
+                    break;
+                case CURVE_STICKS:
+                    if (options_ & CURVE_X_FY)
+                        raster_segment(bx, yi, xi, yi, w, h, plot);
+                    else
+                        raster_segment(xi, by, xi, yi, w, h, plot);
+                    break;
+                default:
+                {
+                    int px, py;
+                    if (raster_coord(xi, px) && raster_coord(yi, py))
+                        raster_disc(px, py, 4, w, h, plot);
+                    break;
+                }
+            }
+            xp= xi;
+            yp= yi;
+        }
+    }
+    image->mark_dirty();
+
+    cr->save();
+    cr->set_source(image, ox, oy);
+    cr->paint();
+    cr->restore();
+}
+
+/*!
+  \brief Draw the point density as a heatmap
   \param painter Painter
   \param xMap x map
   \param yMap y map
   \param from index of the first point to be painted
   \param to index of the last point to be painted
-  \sa Curve::draw
+  \sa Curve::draw, DensityGrid
 */
-void Curve::draw_lsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+void Curve::draw_density_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
     const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
 {
+    density_.update(x_column(xMap), y_column(yMap), from, to, xMap, yMap);
+    density_.paint(cr);
+}
 
-    std::vector<Gdk::Point> polyline;
+/*!
+  \brief Draw step function
+  \param painter Painter
+  \param xMap x map
+  \param yMap y map
+  \param from index of the first point to be painted
+  \param to index of the last point to be painted
 
+  The steps are streamed into a PolylineSink.  Only the previous point
+  is kept, and runs of samples within one pixel column are collapsed
+  into a single vertical span.
+  \sa Curve::draw, PolylineSink
+*/
+void Curve::draw_lsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+    const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
+{
     cr->set_line_width(1.0);
     paint()->set_cr_to_pen(cr);
     bool inverted = options_ & CURVE_X_FY;
     if ( options_ & CURVE_INVERTED )
         inverted = !inverted;
 
-    int i,ip;
-    int xi = xMap.transform(x(from));
-    int yi = yMap.transform(y(from));
-
-    polyline.push_back(Gdk::Point(xi, yi));
-    cr->move_to(xMap.transform(x(from)),yMap.transform(y(from)));
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    PolylineSink sink(cr, options_ & CURVE_X_FY);
+    sink.clip_to_context(cr->get_line_width());
+    sink.set_chunk(stroke_chunk);
 
-    for (i = from+1, ip = 1; i <= to; i++, ip += 2)
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-        xi = xMap.transform(x(i));
-        yi = yMap.transform(y(i));
-        if (inverted)
-        {
-            polyline.push_back(Gdk::Point(xi, polyline[ip-1].get_y()));
-            cr->line_to(xi,polyline[ip-1].get_y());
-        }
-        else
+        const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+        double xp = xMap.raw_x_transform(xs[r0]);
+        double yp = yMap.raw_x_transform(ys[r0]);
+        sink.move_to(xp, yp);
+
+        for (int i = r0+1; i <= r1; i++)
         {
-            polyline.push_back(Gdk::Point(polyline[ip-1].get_x(), yi));
-            cr->line_to(polyline[ip-1].get_x(),yi);
+            const double xi = xMap.raw_x_transform(xs[i]);
+            const double yi = yMap.raw_x_transform(ys[i]);
+            if (inverted)
+                sink.line_to(xi, yp);
+            else
+                sink.line_to(xp, yi);
+            sink.line_to(xi, yi);
+            xp = xi;
+            yp = yi;
         }
-
-        polyline.push_back(Gdk::Point(xi, yi));
-        cr->line_to(xi,yi);
-
     }
+    sink.flush();
     cr->stroke();
     if ( paint()->filled() )
     {
@@ -569,9 +1081,7 @@ void Curve::draw_lsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Re
 void Curve::draw_csteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
     const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
 {
-        std::vector<Gdk::Point> polyline;
-
-   paint()->set_cr_to_pen(cr);
+    paint()->set_cr_to_pen(cr);
 
     cr->set_line_width(1.0);
 
@@ -579,38 +1089,44 @@ void Curve::draw_csteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Re
     if ( options_ & CURVE_INVERTED )
         inverted = !inverted;
 
-    int i,ip;
+    PolylineSink sink(cr, options_ & CURVE_X_FY);
+    sink.clip_to_context(cr->get_line_width());
+    sink.set_chunk(stroke_chunk);
 
-    int xi = xMap.transform(x(from));
-    int yi = yMap.transform(y(from));
-    polyline.push_back(Gdk::Point(xi, yi));
-    cr->move_to(xMap.transform(x(from)),yMap.transform(y(from)));
-
-    for (i = from+1, ip = 0; i <= to; i++, ip += 2)
+    // steps change midway between samples in raw (pixel-linear) values
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-	int xn,yn;
-	if (inverted)
-        {
-            xn= xMap.transform(x(i));
-            yn= yMap.transform((y(i)+y(i-1))*.5);
-            polyline.push_back(Gdk::Point(xi, yn));
-            cr->line_to(xi,yn);
-        }
-	else
+        const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+        double xi = xMap.raw_x_transform(xs[r0]);
+        double yi = yMap.raw_x_transform(ys[r0]);
+        sink.move_to(xi, yi);
+
+        for (int i = r0+1; i <= r1; i++)
         {
-	    xn= xMap.transform((x(i)+x(i-1))*.5);
-	    yn= yMap.transform(y(i));
-	    polyline.push_back(Gdk::Point(xn, yi));
-	    cr->line_to(xn,yi);
+            double xn,yn;
+            if (inverted)
+            {
+                xn= xMap.raw_x_transform(xs[i]);
+                yn= yMap.raw_x_transform((ys[i]+ys[i-1])*.5);
+                sink.line_to(xi, yn);
+            }
+            else
+            {
+                xn= xMap.raw_x_transform((xs[i]+xs[i-1])*.5);
+                yn= yMap.raw_x_transform(ys[i]);
+                sink.line_to(xn, yi);
+            }
+            xi=xn; yi=yn;
+            sink.line_to(xi, yi);
         }
-	xi=xn; yi=yn;
-        polyline.push_back(Gdk::Point(xi, yi));
-        cr->line_to(xi,yi);
+        sink.line_to(xMap.raw_x_transform(xs[r1]),
+                     yMap.raw_x_transform(ys[r1]));
     }
-    xi = xMap.transform(x(to));
-    yi = yMap.transform(y(to));
-    polyline.push_back(Gdk::Point(xi, yi));
-    cr->line_to(xi,yi);
+    sink.flush();
     cr->stroke();
 
     if ( paint()->filled() )
@@ -640,8 +1156,6 @@ void Curve::draw_csteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Re
 void Curve::draw_rsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
     const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
 {
-    std::vector<Gdk::Point> polyline;
-
     paint()->set_cr_to_pen(cr);
 
     cr->set_line_width(1.0);
@@ -650,35 +1164,36 @@ void Curve::draw_rsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::Re
     if ( options_ & CURVE_INVERTED )
         inverted = !inverted;
 
-    int i,ip;
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    PolylineSink sink(cr, options_ & CURVE_X_FY);
+    sink.clip_to_context(cr->get_line_width());
+    sink.set_chunk(stroke_chunk);
 
-        int xi = xMap.transform(x(from));
-        int yi = yMap.transform(y(from));
-
-        cr->move_to(xi,yi);
-
-    for (i = from, ip = 0; i <= to; i++, ip += 2)
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-        int xi = xMap.transform(x(i));
-        int yi = yMap.transform(y(i));
+        const int r0= MAX(r->first, from), r1= MIN(r->second, to);
+        double xp = xMap.raw_x_transform(xs[r0]);
+        double yp = yMap.raw_x_transform(ys[r0]);
+        sink.move_to(xp, yp);
 
-        if ( ip > 0 )
+        for (int i = r0+1; i <= r1; i++)
         {
+            const double xi = xMap.raw_x_transform(xs[i]);
+            const double yi = yMap.raw_x_transform(ys[i]);
+
             if (inverted)
-            {
-                polyline.push_back(Gdk::Point(polyline[ip-2].get_x(), yi));
-                cr->line_to(polyline[ip-2].get_x(), yi);
-            }
+                sink.line_to(xp, yi);
             else
-             {
-                polyline.push_back(Gdk::Point(xi, polyline[ip-2].get_y()));
-                cr->line_to(xi, polyline[ip-2].get_y());
-             }
+                sink.line_to(xi, yp);
+            sink.line_to(xi, yi);
+            xp = xi;
+            yp = yi;
         }
-
-        polyline.push_back(Gdk::Point(xi, yi));
-        cr->line_to(xi,yi);
     }
+    sink.flush();
     cr->stroke();
 //    if ( paint()->filled() )
     {
@@ -776,12 +1291,19 @@ void Curve::draw_symbols_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::R
 //    painter->set_brush(symbol.brush());
 //    painter->set_pen(symbol.pen());
 
-    for (int i = from; i <= to; i++)
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    const Runs &runs= runs_for_(xMap, yMap);
+    Runs::const_iterator r;
+    for (r= run_at_(runs, from); r != runs.end() && r->first <= to; ++r)
     {
-        const int xi = xMap.transform(x(i));
-        const int yi = yMap.transform(y(i));
+        for (int i = MAX(r->first, from); i <= MIN(r->second, to); i++)
+        {
+            const int xi = xMap.raw_transform(xs[i]);
+            const int yi = yMap.raw_transform(ys[i]);
 
-        symbol->draw(cr, painter, xi, yi);
+            symbol->draw(cr, painter, xi, yi);
+        }
     }
 }
 
@@ -824,11 +1346,114 @@ int Curve::data_size() const
 /*!
     \brief Notify a change of attributes.
     This virtual function is called when an attribute of the curve
-    has changed. It can be redefined by derived classes.
-    The default implementation does nothing.
+    has changed. It can be redefined by derived classes, which
+    must call the base implementation.
+    The default implementation advances serial() and emits
+    signal_curve_changed.
 */
 
 void Curve::curve_changed()
 {
+    ++serial_;
     signal_curve_changed();
 }
+
+/*!
+    \brief Notify a change of the data.
+    Called by set_data() and append_data() before curve_changed().
+    Samples before index first are unchanged; first is 0 if the data
+    have been replaced.  Derived classes redefining this function
+    must call the base implementation.
+*/
+void Curve::data_changed(int first)
+{
+    if (first < dataSize_)
+	++rewrites_;
+    dataSize_= data_size();
+    if (first == 0) {
+	density_.reset();
+	xSorted_= true;
+    }
+    // samples with a NaN x are gaps and do not break the order
+    double last= NAN;
+    for (int i= first - 1; xSorted_ && i >= 0 && last != last; --i)
+	last= x_[i];
+    for (int i= first; xSorted_ && i < data_size(); ++i) {
+	if (x_[i] != x_[i]) continue;
+	xSorted_= !(x_[i] < last);
+	last= x_[i];
+    }
+    yIndex_.update(y_data(), data_size(), first);
+    if (first < sketched_) {
+	ySketch_.clear();
+	sketched_= 0;
+    }
+    sketch_y_();
+    logXValid_= MIN(logXValid_, first);
+    logYValid_= MIN(logYValid_, first);
+
+    logRunsValid_= MIN(logRunsValid_, first);
+    update_runs_(runs_, x_data(), y_data(), first, data_size());
+}
+
+/*!
+    \brief Bring runs of valid samples up to date
+
+    Runs before first are kept, the samples from first to n-1 are
+    scanned for values which are not NaN.
+*/
+void Curve::update_runs_(Runs &runs, const double *x, const double *y,
+			 int first, int n)
+{
+    while (!runs.empty() && runs.back().first >= first)
+	runs.pop_back();
+    if (!runs.empty() && runs.back().second >= first)
+	runs.back().second= first - 1;
+    for (int i= first; i < n; ++i) {
+	if (x[i] != x[i] || y[i] != y[i]) continue;
+	if (!runs.empty() && runs.back().second == i - 1)
+	    runs.back().second= i;
+	else
+	    runs.push_back(std::make_pair(i, i));
+    }
+}
+
+/*!
+    \brief Return the runs of samples which can be drawn with two maps
+
+    On linear maps these are valid_runs().  On logarithmic maps,
+    non-positive values have no logarithm and are gaps as well; these
+    runs are built from x_column() and y_column() and kept until the
+    data or the kind of maps change.
+*/
+const Curve::Runs &Curve::runs_for_(const DoubleIntMap &xMap,
+				    const DoubleIntMap &yMap) const
+{
+    const int key= (xMap.logarithmic() ? 1 : 0) | (yMap.logarithmic() ? 2 : 0);
+    if (!key) return runs_;
+
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (key != logRunsKey_) {
+	logRunsKey_= key;
+	logRunsValid_= 0;
+    }
+    if (logRunsValid_ < data_size()) {
+	update_runs_(logRuns_, xs, ys, logRunsValid_, data_size());
+	logRunsValid_= data_size();
+    }
+    return logRuns_;
+}
+
+/*!
+    \brief Return the first of runs which ends at or after i
+    \sa valid_runs, runs_for_
+*/
+Curve::Runs::const_iterator Curve::run_at_(const Runs &runs, int i)
+{
+    return std::lower_bound(runs.begin(), runs.end(), i,
+			    [](const std::pair<int,int> &r, int i) {
+				return r.second < i;
+			    });
+}
@@ -11,6 +11,7 @@
 #define PLOTMM_CURVE_H
 
 #include <vector>
+#include <mutex>
 
 #include "compat.h"
 #if (GTKMM_MAJOR_VERSION == 2 && GTKMM_MINOR_VERSION > 4)
@@ -25,6 +26,9 @@
 
 #include "symbol.h"
 #include "doublerect.h"
+#include "density.h"
+#include "rangeindex.h"
+#include "quantilesketch.h"
 
 namespace Gtk {
   //  class Drawable;
@@ -48,6 +52,7 @@ namespace PlotMM {
 	CURVE_C_STEPS,
 	CURVE_R_STEPS,
 	CURVE_DOTS,
+	CURVE_DENSITY,
 	CurveStyleCnt
     };
 
@@ -91,6 +96,9 @@ namespace PlotMM {
     class Curve : public PlotMM::ObjectBase
     {
     public:
+	//! Index ranges [first, second] of samples, both inclusive
+	typedef std::vector<std::pair<int,int> > Runs;
+
 	Curve(const Glib::ustring &title = "");
 	Curve(const Curve &c);
 	virtual ~Curve();
@@ -101,6 +109,11 @@ namespace PlotMM {
 	virtual bool enabled() { return enabled_; }
 
 	const Curve& operator= (const Curve &c);
+	virtual Glib::RefPtr<Curve> clone() const;
+	virtual bool update_copy(Curve &c) const;
+	virtual bool concurrent_draw() const;
+	//! Return a number which is changed by every curve_changed()
+	unsigned long serial() const { return serial_; }
 
 	// void set_rawData(const double *x, const double *y, int size);
 	virtual void set_data(const double *xData, const double *yData,
@@ -108,18 +121,42 @@ namespace PlotMM {
 	virtual void set_data(const std::vector<double> &xData,
 			      const std::vector<double> &yData);
 	virtual void set_data(const Glib::ArrayHandle<DoublePoint> &data);
+	virtual void append_data(const double *xData, const double *yData,
+				 int size);
+
+	void set_max_size(int n);
+	//! Return the maximum number of samples kept by append_data()
+	int max_size() const { return maxSize_; }
+	//! Return the number of samples dropped from the front so far
+	long long discarded() const { return discarded_; }
 
 	virtual int data_size() const;
 	inline double x(int i) const;
 	inline double y(int i) const;
+	//! Return a pointer to the x values (0 if there are none)
+	const double *x_data() const { return x_.empty() ? 0 : &x_[0]; }
+	//! Return a pointer to the y values (0 if there are none)
+	const double *y_data() const { return y_.empty() ? 0 : &y_[0]; }
+	//! Return the runs of samples whose x and y values are not NaN
+	const Runs &valid_runs() const { return runs_; }
+	const double *x_column(const DoubleIntMap &m) const;
+	const double *y_column(const DoubleIntMap &m) const;
 
 	virtual DoubleRect bounding_rect() const;
+	DoubleRect bounding_rect(bool logX, bool logY) const;
 
 	inline double min_x_value() const { return bounding_rect().get_x1(); }
 	inline double max_x_value() const { return bounding_rect().get_x2(); }
 	inline double min_y_value() const { return bounding_rect().get_y1(); }
 	inline double max_y_value() const { return bounding_rect().get_y2(); }
 
+	bool y_extent(double x1, double x2, double &ymin, double &ymax) const;
+	void index_range(const DoubleIntMap &xMap, int px1, int px2,
+			 int &from, int &to) const;
+	bool y_quantiles(double q1, double q2, double &y1, double &y2) const;
+	//! Query if the x values are in ascending order
+	bool x_sorted() const { return xSorted_; }
+
 	virtual void set_options(CurveOptions t);
 	virtual CurveOptions options() const;
 
@@ -133,6 +170,11 @@ namespace PlotMM {
 				     CurveOptions options = CURVE_AUTO);
 	virtual CurveStyleID curve_style() const;
 	virtual Glib::RefPtr<Paint> paint() const;
+	void set_aliased(bool b);
+	//! Query if lines, sticks and dots are drawn as aliased pixels
+	bool aliased() const { return aliased_; }
+	//! Return the grid used for the CURVE_DENSITY style
+	DensityGrid &density() { return density_; }
 
 	virtual void set_symbol(const Glib::RefPtr<Symbol> &s);
         virtual Glib::RefPtr<Symbol> symbol() const;
@@ -147,6 +189,8 @@ namespace PlotMM {
     protected:
 	virtual void init(const Glib::ustring &title);
 	virtual void copy(const Curve &c);
+	void copy_style_(const Curve &c);
+	void detach_style_();
 
 	virtual void draw_curve_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> p,
 				 int style,
@@ -172,6 +216,10 @@ namespace PlotMM {
 				const DoubleIntMap &xMap,
 				const DoubleIntMap &yMap,
 				int from, int to);
+	virtual void draw_density_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> p,
+				   const DoubleIntMap &xMap,
+				   const DoubleIntMap &yMap,
+				   int from, int to);
 	virtual void draw_lsteps_(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> p,
 				  const DoubleIntMap &xMap,
 				  const DoubleIntMap &yMap,
@@ -184,28 +232,63 @@ namespace PlotMM {
 				  const DoubleIntMap &xMap,
 				  const DoubleIntMap &yMap,
 				  int from, int to);
+	virtual void draw_raster_(const Cairo::RefPtr<Cairo::Context> &cr,
+				  const DoubleIntMap &xMap,
+				  const DoubleIntMap &yMap,
+				  int from, int to);
 	virtual void close_polyline_(const DoubleIntMap &,
 				     const DoubleIntMap &,
 				     std::vector<Gdk::Point> &) const;
 
 	virtual void curve_changed();
+	virtual void data_changed(int first);
 
 	virtual int verify_range(int &i1, int &i2);
+	const Runs &runs_for_(const DoubleIntMap &xMap,
+			      const DoubleIntMap &yMap) const;
+	static Runs::const_iterator run_at_(const Runs &runs, int i);
 
     private:
 	bool enabled_;
 	std::vector<double> x_;
 	std::vector<double> y_;
+	int maxSize_;
+	long long discarded_;
+	unsigned long serial_;
+	// counts changes of samples other than appends; size after the
+	// latest data_changed()
+	unsigned long rewrites_;
+	int dataSize_;
+	RangeIndex yIndex_;
+	bool xSorted_;
+	Runs runs_;
+	QuantileSketch ySketch_;
+	int sketched_;
+	mutable std::vector<double> logX_, logY_;
+	mutable int logXValid_, logYValid_;
+	mutable Runs logRuns_;
+	mutable int logRunsKey_, logRunsValid_;
+	mutable std::mutex logMutex_;
+
+	void x_bounds_(double x1, double x2, int &lo, int &hi) const;
+	void sketch_y_();
+	static void update_runs_(Runs &runs, const double *x, const double *y,
+				 int first, int n);
+	const double *log_column_(const std::vector<double> &v,
+				  std::vector<double> &col, int &valid) const;
 
 	CurveStyleID cStyle_;
 	double baseline_;
 	bool fill_;
+	bool aliased_;
 
 	Glib::RefPtr<Symbol> symbol_;
 
 	Glib::RefPtr<Paint> paint_;
 	Glib::ustring title_;
 
+	DensityGrid density_;
+
 	CurveOptions options_;
     };
 
@@ -0,0 +1,181 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include "density.h"
+#include "threadpool.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+// below this number of points binning is done in the calling thread
+static const int parallel_min = 1 << 16;
+// points whose cells are looked up at once when binning in parallel
+static const int batch_size = 1 << 20;
+
+//! Constructor
+DensityGrid::DensityGrid() :
+    cell_(1),
+    cols_(0), rows_(0),
+    x0_(0), y0_(0),
+    from_(0), binned_(0),
+    valid_(false),
+    tainted_(true),
+    max_(0)
+{
+}
+
+/*! Set the edge length of a grid cell in pixels
+ *
+ *  Changing the cell size discards all counts.
+ */
+void DensityGrid::set_cell_size(int px)
+{
+    px= MAX(1, px);
+    if (px == cell_) return;
+    cell_= px;
+    reset();
+}
+
+//! Set the colormap used to shade the cells
+void DensityGrid::set_colormap(const ColorMap &cm)
+{
+    colormap_= cm;
+    tainted_= true;
+}
+
+/*! Discard all counts
+ *
+ *  Must be called when the data of the curve are replaced.  Points
+ *  appended to the data do not require a reset.
+ */
+void DensityGrid::reset()
+{
+    valid_= false;
+    tainted_= true;
+}
+
+/*! Bring the counts up to date with the points from ... to
+ *
+ *  If the maps are unchanged since the last call and from is the same,
+ *  only points beyond the ones counted before are binned.  Otherwise
+ *  the grid is rebuilt from scratch.
+ */
+void DensityGrid::update(const double *x, const double *y, int from, int to,
+			 const DoubleIntMap &xMap, const DoubleIntMap &yMap)
+{
+    if (!valid_ || from != from_ || to + 1 < binned_ ||
+	xMap != xMap_ || yMap != yMap_) {
+	xMap_= xMap;
+	yMap_= yMap;
+	x0_= MIN(xMap.i1(), xMap.i2());
+	y0_= MIN(yMap.i1(), yMap.i2());
+	cols_= (ABS(xMap.i2() - xMap.i1()) + cell_) / cell_;
+	rows_= (ABS(yMap.i2() - yMap.i1()) + cell_) / cell_;
+	counts_.assign(cols_ * rows_, 0);
+	from_= binned_= from;
+	max_= 0;
+	valid_= true;
+	tainted_= true;
+    }
+    if (binned_ > to) return;
+
+    const int n= to - binned_ + 1;
+    ThreadPool &pool= ThreadPool::global();
+    if (n < parallel_min || pool.size() < 2 || ThreadPool::in_worker()) {
+	bin_(x, y, binned_, to, &counts_[0]);
+    }
+    else {
+	// the cells of a batch of points are looked up in parallel
+	// chunks, then every task counts the points in its own band of
+	// rows into the grid; the extra memory is one int per point of
+	// a batch, however many threads there are
+	const int nchunks= pool.size();
+	const int nbands= MIN(nchunks, rows_);
+	std::vector<int> cells(MIN(n, batch_size));
+	for (int b0= binned_; b0 <= to; b0+= batch_size) {
+	    const int m= MIN(batch_size, to - b0 + 1);
+	    pool.parallel_for(nchunks, [&](int k) {
+		    const int i1= int((long long)m * k / nchunks);
+		    const int i2= int((long long)m * (k + 1) / nchunks);
+		    for (int i= i1; i < i2; ++i)
+			cells[i]= cell_index_(x[b0 + i], y[b0 + i]);
+		});
+	    pool.parallel_for(nbands, [&](int k) {
+		    const int c0= cols_ * int((long long)rows_ * k / nbands);
+		    const int c1= cols_ * int((long long)rows_ * (k + 1) / nbands);
+		    for (int i= 0; i < m; ++i) {
+			const int c= cells[i];
+			if (c >= c0 && c < c1) ++counts_[c];
+		    }
+		});
+	}
+    }
+    binned_= to + 1;
+
+    for (unsigned int c= 0; c < counts_.size(); ++c)
+	max_= MAX(max_, counts_[c]);
+    tainted_= true;
+}
+
+/*! Paint the grid
+ *
+ *  The cells are shaded into an image surface of one pixel per cell
+ *  which is then painted scaled by cell_size() without interpolation.
+ */
+void DensityGrid::paint(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    if (!valid_ || cols_ <= 0 || rows_ <= 0) return;
+    if (tainted_) render_();
+
+    Cairo::RefPtr<Cairo::SurfacePattern> pattern=
+	Cairo::SurfacePattern::create(surface_);
+    pattern->set_filter(Cairo::FILTER_NEAREST);
+
+    cr->save();
+    cr->translate(x0_ - 0.5, y0_ - 0.5);
+    cr->scale(cell_, cell_);
+    cr->set_source(pattern);
+    cr->paint();
+    cr->restore();
+}
+
+//! Return the index of the cell a point falls into, -1 if none
+int DensityGrid::cell_index_(double x, double y) const
+{
+    // NaNs fail both comparisons and are skipped
+    const double px= xMap_.raw_x_transform(x) - x0_ + 0.5;
+    if (!(px >= 0.0 && px < cols_ * cell_)) return -1;
+    const double py= yMap_.raw_x_transform(y) - y0_ + 0.5;
+    if (!(py >= 0.0 && py < rows_ * cell_)) return -1;
+    return (int(py) / cell_) * cols_ + int(px) / cell_;
+}
+
+//! Count the points from ... to into counts
+void DensityGrid::bin_(const double *x, const double *y, int from, int to,
+		       uint32_t *counts) const
+{
+    for (int i= from; i <= to; ++i) {
+	const int c= cell_index_(x[i], y[i]);
+	if (c >= 0) ++counts[c];
+    }
+}
+
+//! Shade the counts into the image surface
+void DensityGrid::render_()
+{
+    if (!surface_ || surface_->get_width() != cols_ ||
+	surface_->get_height() != rows_)
+	surface_= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+					      cols_, rows_);
+
+    surface_->flush();
+    colormap_.shade(&counts_[0], cols_, rows_, max_,
+		    surface_->get_data(), surface_->get_stride());
+    surface_->mark_dirty();
+    tainted_= false;
+}
@@ -0,0 +1,82 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_DENSITY_H
+#define PLOTMM_DENSITY_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include "colormap.h"
+#include "doubleintmap.h"
+
+namespace PlotMM {
+
+    /*! @brief A grid counting data points per pixel cell
+     *
+     *  DensityGrid is used by Curve to draw the CURVE_DENSITY style.
+     *  Instead of painting every point, the transformed points are
+     *  binned into a grid of cells of cell_size() pixels.  The counts
+     *  are mapped through a ColorMap (on a logarithmic scale) into an
+     *  image surface which is painted in one go.
+     *
+     *  As long as the maps and the canvas size stay the same, points
+     *  appended to the curve are binned incrementally and the points
+     *  already counted are not visited again.  Large batches of
+     *  points are binned in parallel on the ThreadPool, every task
+     *  counting into its own band of rows of the one grid.
+     *
+     *  \sa Curve::set_curve_style, Curve::density
+     */
+    class DensityGrid
+    {
+    public:
+	DensityGrid();
+
+	void set_cell_size(int px);
+	//! Return the edge length of a grid cell in pixels
+	int cell_size() const { return cell_; }
+
+	//! Return the colormap used to shade the cells
+	ColorMap &colormap() { return colormap_; }
+	void set_colormap(const ColorMap &cm);
+
+	//! Return the highest count of any cell
+	uint32_t max_count() const { return max_; }
+
+	void reset();
+	void update(const double *x, const double *y, int from, int to,
+		    const DoubleIntMap &xMap, const DoubleIntMap &yMap);
+	void paint(const Cairo::RefPtr<Cairo::Context> &cr);
+
+    private:
+	int cell_index_(double x, double y) const;
+	void bin_(const double *x, const double *y, int from, int to,
+		  uint32_t *counts) const;
+	void render_();
+
+	int cell_;
+	int cols_, rows_;
+	int x0_, y0_;
+	DoubleIntMap xMap_, yMap_;
+	int from_, binned_;
+	bool valid_;
+	bool tainted_;
+	uint32_t max_;
+
+	std::vector<uint32_t> counts_;
+	ColorMap colormap_;
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+    };
+
+}
+
+#endif
@@ -26,6 +26,9 @@ DoubleIntMap::DoubleIntMap()
     d_y1 = 0;
     d_y2 = 1;
     d_cnv = 1.0;
+    d_log = false;
+    d_rx1 = 0.0;
+    d_rcnv = 1.0;
 }
 
 
@@ -45,8 +48,9 @@ DoubleIntMap::DoubleIntMap(int i1, int i2,
 			   double d1, double d2, bool logarithmic)
 {
     d_log = logarithmic;
+    d_x1 = d_x2 = 0.0;
     set_int_range(i1,i2);
-    set_dbl_range(d1, d2);
+    set_dbl_range(d1, d2, logarithmic);
 }
 
 /*!
@@ -56,6 +60,26 @@ DoubleIntMap::~DoubleIntMap()
 {
 }
 
+/*!
+  \brief Equality operator
+  \return true if both the double and the integer intervals and the
+  scaling type of the maps are equal
+*/
+bool DoubleIntMap::operator==(const DoubleIntMap &m) const
+{
+    return d_x1 == m.d_x1 && d_x2 == m.d_x2 &&
+	d_y1 == m.d_y1 && d_y2 == m.d_y2 && d_log == m.d_log;
+}
+
+/*!
+  \brief Inequality operator
+  \return true if the maps differ
+*/
+bool DoubleIntMap::operator!=(const DoubleIntMap &m) const
+{
+    return !(*this == m);
+}
+
 /*!
   \return true if a value x lies inside or at the border of the
   map's double range.
@@ -187,6 +211,26 @@ double DoubleIntMap::x_transform(double x) const
 }
 
 
+/*!
+  \brief Return the raw value of x for a linear or logarithmic map
+
+  For logarithmic maps, this is log10(x).  Positive values below
+  LogMin are mapped to log10(LogMin), like the borders of the double
+  interval.  Non-positive values have no logarithm and are mapped to
+  NaN, so that curves show a gap there.
+  \sa raw_transform
+*/
+double DoubleIntMap::raw_value(double x, bool lg)
+{
+    if (!lg)
+       return x;
+    if (!(x > 0.0))
+       return NAN;
+    if (x < LogMin)
+       x = LogMin;
+    return log10(x);
+}
+
 /*!
   \brief Re-calculate the conversion factor.
 */
@@ -196,4 +240,8 @@ void DoubleIntMap::newFactor()
        d_cnv = double(d_y2 - d_y1) / (d_x2 - d_x1);
     else
        d_cnv = 0.0;
+
+    // the natural logarithm of the double interval in terms of log10
+    d_rx1 = d_log ? d_x1 / M_LN10 : d_x1;
+    d_rcnv = d_log ? d_cnv * M_LN10 : d_cnv;
 }
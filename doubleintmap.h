@@ -56,6 +56,9 @@ namespace PlotMM {
 	DoubleIntMap(int i1, int i2, double d1, double d2, bool lg = false);
 	virtual ~DoubleIntMap();
 
+	bool operator==(const DoubleIntMap &) const;
+	bool operator!=(const DoubleIntMap &) const;
+
 	bool contains(double x) const;
 	bool contains(int x) const;
 
@@ -68,6 +71,10 @@ namespace PlotMM {
 	int lim_transform(double x) const;
 	double x_transform(double x) const;
 
+	inline int raw_transform(double v) const;
+	inline double raw_x_transform(double v) const;
+	static double raw_value(double x, bool lg);
+
 	inline double d1() const;
 	inline double d2() const;
 	inline int i1() const;
@@ -84,6 +91,7 @@ namespace PlotMM {
 	int d_y1, d_y2;     // integer interval boundaries
 	double d_cnv;       // conversion factor
 	bool d_log;     // logarithmic scale?
+	double d_rx1, d_rcnv;  // d_x1 and d_cnv for raw values
     };
 
     /*!
@@ -149,6 +157,29 @@ namespace PlotMM {
 	    return d_y1 + ROUND((x - d_x1) * d_cnv);
     }
 
+    /*! Transform a raw value into the integer interval
+     *
+     *  Raw values are the values themselves for linear maps and their
+     *  decadic logarithms for logarithmic maps, see raw_value().  The
+     *  mapping of raw values is affine in both cases, so data whose
+     *  logarithms are cached can be mapped without calling log().
+     *
+     *  \sa Curve::x_column, Curve::y_column
+     */
+    inline int DoubleIntMap::raw_transform(double v) const
+    {
+	return d_y1 + ROUND((v - d_rx1) * d_rcnv);
+    }
+
+    /*! Transform a raw value exactly
+     *
+     *  \sa raw_transform, x_transform
+     */
+    inline double DoubleIntMap::raw_x_transform(double v) const
+    {
+	return double(d_y1) + (v - d_rx1) * d_rcnv;
+    }
+
 }
 
 #endif
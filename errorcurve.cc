@@ -75,6 +75,15 @@ const ErrorCurve& ErrorCurve::operator=(const ErrorCurve &c)
     return *this;
 }
 
+//! Return a copy of the curve to be drawn by another thread
+Glib::RefPtr<Curve> ErrorCurve::clone() const
+{
+    ErrorCurve *c= new ErrorCurve(*this);
+    c->detach_style_();
+    c->epaint_= Glib::RefPtr<Paint>(new Paint(*epaint_));
+    return Glib::RefPtr<Curve>(c);
+}
+
 /*! Return a reference to the Paint the curve is drawn with
  */
 Glib::RefPtr<Paint> ErrorCurve::error_paint() const
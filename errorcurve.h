@@ -31,6 +31,7 @@ namespace PlotMM {
 	virtual ~ErrorCurve();
 
 	const ErrorCurve& operator= (const ErrorCurve &c);
+	virtual Glib::RefPtr<Curve> clone() const;
 
 	// void set_rawData(const double *x, const double *y, int size);
 	virtual void set_data(const double *xData, const double *yData,
@@ -0,0 +1,168 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <string.h>
+
+#include <cairomm/context.h>
+#include <pangomm/layout.h>
+
+#include "glyphatlas.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+// characters produced by ScaleLabels::format() for finite values
+static const char glyph_set[]= "0123456789+-.e";
+
+//! Constructor
+GlyphAtlas::GlyphAtlas() :
+    height_(0),
+    top_(0),
+    bottom_(0)
+{
+}
+
+//! Return the characters held by the atlas
+const char *GlyphAtlas::charset()
+{
+    return glyph_set;
+}
+
+/*! Render all glyphs
+ *
+ *  Each cell spans the union of the ink and the logical rectangle of
+ *  its glyph, so overhanging ink is kept.
+ *
+ *  \param layout layout with the font to be used; its text is changed
+ */
+void GlyphAtlas::build(const Glib::RefPtr<Pango::Layout> &layout)
+{
+    // blank columns between cells keep antialiased edges apart
+    static const int padding= 1;
+
+    int width= 0;
+    height_= 0;
+    top_= bottom_= 0;
+    for (int i= 0; i < Glyphs; ++i) {
+	Pango::Rectangle ink, logical;
+	layout->set_text(Glib::ustring(1, glyph_set[i]));
+	layout->get_pixel_extents(ink, logical);
+	int l= logical.get_x(), r= l + logical.get_width();
+	int t= logical.get_y(), b= t + logical.get_height();
+	if (ink.get_width() > 0 && ink.get_height() > 0) {
+	    l= MIN(l, ink.get_x());
+	    r= MAX(r, ink.get_x() + ink.get_width());
+	    t= MIN(t, ink.get_y());
+	    b= MAX(b, ink.get_y() + ink.get_height());
+	}
+	left_[i]= l;
+	right_[i]= r;
+	x_[i]= width - l;
+	w_[i]= logical.get_width();
+	width+= r - l + padding;
+	height_= MAX(height_, logical.get_height());
+	top_= MIN(top_, t);
+	bottom_= MAX(bottom_, b);
+    }
+
+    surface_= Cairo::ImageSurface::create(Cairo::FORMAT_A8,
+					  MAX(width, 1),
+					  MAX(bottom_ - top_, 1));
+    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(surface_);
+    cr->set_source_rgba(0.0, 0.0, 0.0, 1.0);
+    for (int i= 0; i < Glyphs; ++i) {
+	layout->set_text(Glib::ustring(1, glyph_set[i]));
+	cr->move_to(x_[i], -top_);
+	layout->show_in_cairo_context(cr);
+    }
+    surface_->flush();
+}
+
+//! Drop the glyphs, e.g. after the font has changed
+void GlyphAtlas::clear()
+{
+    surface_= Cairo::RefPtr<Cairo::ImageSurface>();
+    height_= top_= bottom_= 0;
+}
+
+//! Return the cell of a character, -1 if it is not in charset()
+int GlyphAtlas::index_(char c)
+{
+    const char *p= c ? strchr(glyph_set, c) : 0;
+    return p ? int(p - glyph_set) : -1;
+}
+
+//! Query if text can be composed from the atlas
+bool GlyphAtlas::supports(const Glib::ustring &text) const
+{
+    if (!valid() || text.empty()) return false;
+    const std::string &raw= text.raw();
+    for (unsigned int i= 0; i < raw.size(); ++i)
+	if (index_(raw[i]) < 0) return false;
+    return true;
+}
+
+//! Return the width of a supported text in pixels
+int GlyphAtlas::text_width(const Glib::ustring &text) const
+{
+    const std::string &raw= text.raw();
+    int w= 0;
+    for (unsigned int i= 0; i < raw.size(); ++i)
+	w+= w_[index_(raw[i])];
+    return w;
+}
+
+/*! Compose a supported text into an alpha mask
+ *
+ *  The mask covers the ink of all glyphs, where cells overlap their
+ *  coverage is combined by maximum.
+ *
+ *  \param text text for which supports() is true
+ *  \param dx returns the column of the mask's origin relative to the
+ *         top left corner of the text, like that of a Pango layout
+ *  \param dy returns the row of the mask's origin likewise
+ */
+Cairo::RefPtr<Cairo::ImageSurface> GlyphAtlas::compose(const Glib::ustring &text,
+						       int &dx, int &dy) const
+{
+    const std::string &raw= text.raw();
+    int lo= 0, hi= 0, x= 0;
+    for (unsigned int i= 0; i < raw.size(); ++i) {
+	const int g= index_(raw[i]);
+	lo= MIN(lo, x + left_[g]);
+	hi= MAX(hi, x + right_[g]);
+	x+= w_[g];
+    }
+    dx= lo;
+    dy= top_;
+
+    const int rows= bottom_ - top_;
+    Cairo::RefPtr<Cairo::ImageSurface> mask=
+	Cairo::ImageSurface::create(Cairo::FORMAT_A8, MAX(hi - lo, 1),
+				    MAX(rows, 1));
+    mask->flush();
+    const unsigned char *src= surface_->get_data();
+    const int sstride= surface_->get_stride();
+    unsigned char *dst= mask->get_data();
+    const int dstride= mask->get_stride();
+
+    x= -lo;
+    for (unsigned int i= 0; i < raw.size(); ++i) {
+	const int g= index_(raw[i]);
+	const int n= right_[g] - left_[g];
+	for (int r= 0; r < rows; ++r) {
+	    const unsigned char *s= src + r * sstride + x_[g] + left_[g];
+	    unsigned char *d= dst + r * dstride + x + left_[g];
+	    for (int c= 0; c < n; ++c)
+		d[c]= MAX(d[c], s[c]);
+	}
+	x+= w_[g];
+    }
+    mask->mark_dirty();
+    return mask;
+}
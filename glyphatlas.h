@@ -0,0 +1,75 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_GLYPHATLAS_H
+#define PLOTMM_GLYPHATLAS_H
+
+#include <string>
+
+#include <glibmm/refptr.h>
+#include <glibmm/ustring.h>
+#include <cairomm/surface.h>
+
+namespace Pango {
+    class Layout;
+}
+
+namespace PlotMM {
+
+    /*! @brief Pre-rendered glyphs for numeric labels
+     *
+     *  build() renders the characters of charset() once with Pango
+     *  into an alpha-only surface.  Texts consisting only of these
+     *  characters can then be composed into an alpha mask by copying
+     *  glyph cells, without shaping, and painted with
+     *  Cairo::Context::mask().  Glyphs are placed at their advance
+     *  widths without kerning, which suits the tabular digits of
+     *  most fonts.  Other texts have to be drawn with Pango.
+     *
+     *  Each cell holds the ink of its glyph even where it overhangs
+     *  the logical box, e.g. italic or bold glyphs, and cells are
+     *  separated by a blank column so that antialiasing does not
+     *  bleed into the neighbouring glyph.  The mask of a text may
+     *  therefore extend beyond its logical box; compose() returns
+     *  where it lies.
+     */
+    class GlyphAtlas
+    {
+    public:
+	GlyphAtlas();
+
+	void build(const Glib::RefPtr<Pango::Layout> &layout);
+	void clear();
+	//! Query if build() has been called
+	bool valid() const { return bool(surface_); }
+
+	bool supports(const Glib::ustring &text) const;
+	int text_width(const Glib::ustring &text) const;
+	//! Return the logical height of a text
+	int height() const { return height_; }
+	Cairo::RefPtr<Cairo::ImageSurface> compose(const Glib::ustring &text,
+						   int &dx, int &dy) const;
+
+	static const char *charset();
+
+    private:
+	static int index_(char c);
+
+	enum { Glyphs = 14 };
+	int x_[Glyphs];		// column of the glyph origin in the atlas
+	int w_[Glyphs];		// advance width
+	int left_[Glyphs];	// cell columns relative to the origin
+	int right_[Glyphs];
+	int height_;
+	int top_, bottom_;	// cell rows relative to the logical top
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+    };
+
+}
+
+#endif
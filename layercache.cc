@@ -0,0 +1,105 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include "layercache.h"
+#include "curve.h"
+#include "threadpool.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+//! Constructor
+LayerCache::LayerCache() :
+    width_(0),
+    height_(0)
+{
+}
+
+/*! Bring the layers of the given curves up to date
+ *
+ *  Layers of curves not in items are dropped.
+ *
+ *  \param items curves to be drawn, each with a unique key
+ *  \return number of layers drawn
+ */
+int LayerCache::update(const std::vector<Item> &items, int width, int height)
+{
+    const bool resized= width != width_ || height != height_;
+    width_= width;
+    height_= height;
+
+    std::map<int, Layer> layers;
+    std::vector<Layer *> dirty;
+    for (unsigned int i= 0; i < items.size(); ++i) {
+	const Item &it= items[i];
+	Layer &l= layers[it.key];
+	std::map<int, Layer>::iterator old= layers_.find(it.key);
+	if (old != layers_.end()) {
+	    l= old->second;
+	    if (resized)
+		l.surface= Cairo::RefPtr<Cairo::ImageSurface>();
+	}
+	else
+	    l.valid= false;
+
+	if (!l.valid || l.curve != it.curve ||
+	    l.serial != it.curve->serial() ||
+	    l.xMap != it.xMap || l.yMap != it.yMap || !l.surface) {
+	    l.curve= it.curve;
+	    l.serial= it.curve->serial();
+	    l.xMap= it.xMap;
+	    l.yMap= it.yMap;
+	    dirty.push_back(&l);
+	}
+    }
+    layers_.swap(layers);
+    layers.clear();
+
+    if (width_ <= 0 || height_ <= 0) return 0;
+    ThreadPool::global().parallel_for(dirty.size(), [&](int k) {
+	    draw_(*dirty[k], width_, height_);
+	});
+    return dirty.size();
+}
+
+//! Draw a layer, reusing its surface if there is one
+void LayerCache::draw_(Layer &l, int width, int height)
+{
+    if (!l.surface)
+	l.surface= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+					       width, height);
+    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(l.surface);
+    cr->save();
+    cr->set_operator(Cairo::OPERATOR_CLEAR);
+    cr->paint();
+    cr->restore();
+    l.curve->draw(cr, Glib::RefPtr<Gdk::Window>(), l.xMap, l.yMap);
+    l.surface->flush();
+    l.valid= true;
+}
+
+//! Composite all layers
+void LayerCache::paint(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    cr->save();
+    for (std::map<int, Layer>::iterator l= layers_.begin();
+	 l != layers_.end(); ++l) {
+	if (!l->second.valid) continue;
+	cr->set_source(l->second.surface, 0.0, 0.0);
+	cr->paint();
+    }
+    cr->restore();
+}
+
+//! Redraw all layers at the next update()
+void LayerCache::invalidate()
+{
+    for (std::map<int, Layer>::iterator l= layers_.begin();
+	 l != layers_.end(); ++l)
+	l->second.valid= false;
+}
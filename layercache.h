@@ -0,0 +1,72 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_LAYERCACHE_H
+#define PLOTMM_LAYERCACHE_H
+
+#include <map>
+#include <vector>
+
+#include <glibmm/refptr.h>
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include "doubleintmap.h"
+
+namespace PlotMM {
+
+    class Curve;
+
+    /*! @brief One image surface per curve, drawn in parallel
+     *
+     *  update() draws every curve whose layer is out of date into its
+     *  own transparent surface the size of the canvas.  The layers are
+     *  drawn concurrently on the ThreadPool while the calling thread
+     *  waits, so the curves must not be changed by other threads
+     *  meanwhile.  A layer is out of date if Curve::serial() or one of
+     *  the maps has changed, if the canvas has been resized or after
+     *  invalidate().
+     *
+     *  paint() composites the layers in the order of their keys.
+     */
+    class LayerCache
+    {
+    public:
+	//! A curve together with the maps it is drawn with
+	struct Item
+	{
+	    int key;
+	    Glib::RefPtr<Curve> curve;
+	    DoubleIntMap xMap, yMap;
+	};
+
+	LayerCache();
+
+	int update(const std::vector<Item> &items, int width, int height);
+	void paint(const Cairo::RefPtr<Cairo::Context> &cr);
+	void invalidate();
+
+    private:
+	struct Layer
+	{
+	    Glib::RefPtr<Curve> curve;
+	    unsigned long serial;
+	    DoubleIntMap xMap, yMap;
+	    bool valid;
+	    Cairo::RefPtr<Cairo::ImageSurface> surface;
+	};
+
+	static void draw_(Layer &l, int width, int height);
+
+	std::map<int, Layer> layers_;
+	int width_, height_;
+    };
+
+}
+
+#endif
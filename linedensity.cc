@@ -0,0 +1,171 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <algorithm>
+
+#include "linedensity.h"
+#include "curve.h"
+#include "raster.h"
+#include "threadpool.h"
+
+using namespace PlotMM;
+
+//! Constructor
+LineDensity::LineDensity() :
+    width_(0),
+    height_(0),
+    max_(0),
+    valid_(false)
+{
+}
+
+/*! Rasterize the given curves into the accumulation buffer
+ *
+ *  Nothing is done if neither the curves, their Curve::serial() nor
+ *  their maps nor the canvas size have changed since the last call.
+ *  Otherwise the buffer is cleared and all curves are rasterized
+ *  again.  Disabled curves should not be passed in.
+ *
+ *  \param width width of the canvas
+ *  \param height height of the canvas
+ */
+void LineDensity::update(const std::vector<Trace> &traces,
+			 int width, int height)
+{
+    width= MAX(0, width);
+    height= MAX(0, height);
+    bool changed= !valid_ || width != width_ || height != height_ ||
+	traces.size() != traces_.size();
+    for (unsigned int i= 0; !changed && i < traces.size(); ++i) {
+	changed= traces[i].curve != traces_[i].curve ||
+	    traces[i].curve->serial() != serials_[i] ||
+	    traces[i].xMap != traces_[i].xMap ||
+	    traces[i].yMap != traces_[i].yMap;
+    }
+    if (!changed) return;
+    traces_= traces;
+    serials_.resize(traces.size());
+    for (unsigned int i= 0; i < traces.size(); ++i)
+	serials_[i]= traces[i].curve->serial();
+    valid_= true;
+
+    width_= width;
+    height_= height;
+    const int cells= width_ * height_;
+    accum_.assign(cells, 0);
+    max_= 0;
+    if (cells == 0 || traces.empty()) return;
+
+    ThreadPool &pool= ThreadPool::global();
+    const int ntasks= MIN(int(pool.size()), int(traces.size()));
+    if (ntasks < 2 || ThreadPool::in_worker()) {
+	std::vector<uint32_t> pixels;
+	for (unsigned int i= 0; i < traces.size(); ++i) {
+	    trace_(traces[i], pixels);
+	    for (unsigned int p= 0; p < pixels.size(); ++p)
+		++accum_[pixels[p]];
+	}
+    }
+    else {
+	// a batch of curves is traced in parallel into sorted pixel
+	// lists, then every task adds the pixels of its own band of
+	// rows from all lists; no task needs a buffer of the canvas size
+	std::vector<std::vector<uint32_t> > pixels(ntasks);
+	for (unsigned int b0= 0; b0 < traces.size(); b0+= ntasks) {
+	    const int m= MIN(ntasks, int(traces.size() - b0));
+	    pool.parallel_for(m, [&](int k) {
+		    trace_(traces[b0 + k], pixels[k]);
+		});
+	    pool.parallel_for(ntasks, [&](int k) {
+		    const uint32_t c0= uint32_t((long long)height_ * k / ntasks) * width_;
+		    const uint32_t c1= uint32_t((long long)height_ * (k + 1) / ntasks) * width_;
+		    for (int j= 0; j < m; ++j) {
+			std::vector<uint32_t>::const_iterator p=
+			    std::lower_bound(pixels[j].begin(), pixels[j].end(), c0);
+			for (; p != pixels[j].end() && *p < c1; ++p)
+			    ++accum_[*p];
+		    }
+		});
+	}
+    }
+
+    for (int c= 0; c < cells; ++c)
+	max_= MAX(max_, accum_[c]);
+
+    if (!surface_ || surface_->get_width() != width_ ||
+	surface_->get_height() != height_)
+	surface_= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+					      width_, height_);
+    surface_->flush();
+    colormap_.shade(&accum_[0], width_, height_, max_,
+		    surface_->get_data(), surface_->get_stride());
+    surface_->mark_dirty();
+}
+
+/*! Make the next update() rasterize the curves even if they seem
+ *  unchanged, e.g. after the colormap has been changed
+ */
+void LineDensity::invalidate()
+{
+    valid_= false;
+}
+
+//! Paint the shaded buffer unfiltered, each pixel centred on its coordinate
+void LineDensity::paint(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    if (!surface_ || max_ == 0) return;
+    Cairo::RefPtr<Cairo::SurfacePattern> pattern=
+	Cairo::SurfacePattern::create(surface_);
+    pattern->set_filter(Cairo::FILTER_NEAREST);
+
+    cr->save();
+    cr->translate(-0.5, -0.5);
+    cr->set_source(pattern);
+    cr->paint();
+    cr->restore();
+}
+
+/*! Collect the pixels touched by one curve
+ *
+ *  pixels receives the sorted indices of the pixels, each only once,
+ *  so that every pixel is counted once per curve.
+ */
+void LineDensity::trace_(const Trace &t, std::vector<uint32_t> &pixels) const
+{
+    const Curve *c= t.curve;
+    const int n= c->data_size();
+    pixels.clear();
+    if (n <= 0) return;
+
+    const int w= width_;
+    const int h= height_;
+    auto plot= [&](int x, int y) { pixels.push_back(y * w + x); };
+
+    const double *xs= c->x_column(t.xMap);
+    const double *ys= c->y_column(t.yMap);
+    double xp= 0.0, yp= 0.0;
+    bool open= false;
+    for (int i= 0; i < n; ++i) {
+	const double xi= t.xMap.raw_x_transform(xs[i]);
+	const double yi= t.yMap.raw_x_transform(ys[i]);
+	if (xi != xi || yi != yi) {
+	    open= false;
+	    continue;
+	}
+	if (open)
+	    raster_segment(xp, yp, xi, yi, w, h, plot);
+	else
+	    raster_segment(xi, yi, xi, yi, w, h, plot);
+	xp= xi;
+	yp= yi;
+	open= true;
+    }
+
+    std::sort(pixels.begin(), pixels.end());
+    pixels.erase(std::unique(pixels.begin(), pixels.end()), pixels.end());
+}
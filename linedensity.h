@@ -0,0 +1,76 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_LINEDENSITY_H
+#define PLOTMM_LINEDENSITY_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include "colormap.h"
+#include "doubleintmap.h"
+
+namespace PlotMM {
+
+    class Curve;
+
+    /*! @brief Accumulate many curves into one line density image
+     *
+     *  Every curve is rasterized as a 1-px aliased polyline into an
+     *  integer accumulation buffer the size of the canvas.  A curve
+     *  adds at most one to any pixel, even if it crosses the pixel
+     *  several times, so the buffer counts how many curves pass
+     *  through each pixel.  The buffer is shaded through a ColorMap.
+     *
+     *  Curves are traced in parallel on the ThreadPool in batches;
+     *  the pixels of a batch are then added by tasks owning disjoint
+     *  bands of rows of the one buffer.  The buffer is kept and only
+     *  rebuilt when a curve, its serial number or a map has changed.
+     *
+     *  \sa Plot::set_aggregated
+     */
+    class LineDensity
+    {
+    public:
+	//! A curve together with the maps it is drawn with
+	struct Trace {
+	    const Curve *curve;
+	    DoubleIntMap xMap;
+	    DoubleIntMap yMap;
+	};
+
+	LineDensity();
+
+	//! Return the colormap used to shade the buffer
+	ColorMap &colormap() { return colormap_; }
+	//! Return the number of curves passing the busiest pixel
+	uint32_t max_count() const { return max_; }
+
+	void update(const std::vector<Trace> &traces, int width, int height);
+	void invalidate();
+	void paint(const Cairo::RefPtr<Cairo::Context> &cr);
+
+    private:
+	void trace_(const Trace &t, std::vector<uint32_t> &pixels) const;
+
+	int width_, height_;
+	uint32_t max_;
+	bool valid_;
+	std::vector<Trace> traces_;
+	std::vector<unsigned long> serials_;
+	std::vector<uint32_t> accum_;
+	ColorMap colormap_;
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+    };
+
+}
+
+#endif
@@ -24,7 +24,10 @@ using namespace PlotMM;
 {
 }
 
-Paint::Paint(const Paint &s)
+Paint::Paint(const Paint &s) :
+    PlotMM::ObjectBase(s),
+    pColor_(s.pColor_),
+    bColor_(s.bColor_)
 {
     size_= s.size_;
     sizeB_= s.sizeB_;
@@ -64,9 +67,11 @@ void Paint::set_brush_color(const Gdk::RGBA &c)
     filled_= true;
 }
 
+//! Set the source of gc to the pen color, including its alpha
 void Paint::set_cr_to_pen(const Cairo::RefPtr<Cairo::Context> &gc)
 {
-    gc->set_source_rgb(pColor_.get_red(), pColor_.get_green(), pColor_.get_blue());
+    gc->set_source_rgba(pColor_.get_red(), pColor_.get_green(),
+			pColor_.get_blue(), pColor_.get_alpha());
 }
 
 void Paint::set_cr_to_brush(const Cairo::RefPtr<Cairo::Context> &gc)
@@ -49,6 +49,8 @@ namespace PlotMM {
 
 	void set_pen_color(const Gdk::RGBA &);
 	void set_brush_color(const Gdk::RGBA &);
+	//! Return the color lines are drawn with
+	const Gdk::RGBA &pen_color() const { return pColor_; }
 
 	void set_cr_to_pen(const Cairo::RefPtr<Cairo::Context> &);
 	void set_cr_to_brush(const Cairo::RefPtr<Cairo::Context> &);
@@ -0,0 +1,223 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <algorithm>
+#include <math.h>
+
+#include <glibmm/main.h>
+
+#include "doubleintmap.h"
+#include "persistence.h"
+#include "raster.h"
+
+using namespace PlotMM;
+
+/*!
+  \brief Ctor
+  \param title title of the curve
+*/
+PersistenceCurve::PersistenceCurve(const Glib::ustring &title) :
+    Curve(title),
+    decay_(0.9),
+    pending_(false),
+    faded_(0),
+    width_(0),
+    height_(0)
+{
+}
+
+//! Destructor
+PersistenceCurve::~PersistenceCurve()
+{
+    fade_timer_.disconnect();
+}
+
+/*! Set the factor the history is multiplied with per frame interval
+ *
+ *  0 shows only the latest sweep, values close to 1 give a long
+ *  persistence.  f is limited to [0,1).  The history decays with the
+ *  time elapsed between frames, not with the number of sweeps.
+ *
+ *  \sa frame_interval
+ */
+void PersistenceCurve::set_decay(double f)
+{
+    decay_= value_limes(f, 0.0, 0.999);
+}
+
+/*! Forget all previous sweeps
+ *
+ *  The image is cleared at once, not only when the next sweep is
+ *  added, and the curve is redrawn.
+ */
+void PersistenceCurve::clear_history()
+{
+    accum_.assign(accum_.size(), 0.0f);
+    if (surface_) {
+	const uint32_t blank= colormap_.pixel(0);
+	surface_->flush();
+	unsigned char *data= surface_->get_data();
+	const int stride= surface_->get_stride();
+	for (int r= 0; r < height_; ++r) {
+	    uint32_t *row= reinterpret_cast<uint32_t *>(data + r * stride);
+	    std::fill(row, row + width_, blank);
+	}
+	surface_->mark_dirty();
+    }
+    curve_changed();
+}
+
+/*! The history lives in this curve, so it cannot be drawn from a copy
+ *
+ *  \return an empty pointer
+ */
+Glib::RefPtr<Curve> PersistenceCurve::clone() const
+{
+    return Glib::RefPtr<Curve>();
+}
+
+//! A new sweep is rasterized at the next draw()
+void PersistenceCurve::data_changed(int first)
+{
+    Curve::data_changed(first);
+    pending_= true;
+}
+
+/*!
+  \brief Draw the history including the current sweep
+  \param painter Painter
+  \param xMap maps x-values into pixel coordinates.
+  \param yMap maps y-values into pixel coordinates.
+  \param from index of the first point of the sweep
+  \param to index of the last point of the sweep. If to < 0 the
+         sweep ends with the last point of the data.
+*/
+void PersistenceCurve::draw(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+    const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
+{
+    const int w= ABS(xMap.i2() - xMap.i1()) + 1;
+    const int h= ABS(yMap.i2() - yMap.i1()) + 1;
+    if (w != width_ || h != height_ || xMap != xMap_ || yMap != yMap_) {
+	width_= w;
+	height_= h;
+	xMap_= xMap;
+	yMap_= yMap;
+	accum_.assign(w * h, 0.0f);
+	hit_.assign(w * h, 0);
+	surface_= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w, h);
+	pending_= true;
+    }
+
+    if (pending_) {
+	if (to < 0)
+	    to = data_size() - 1;
+	if (verify_range(from, to) > 0)
+	    add_sweep_(xMap, yMap, from, to);
+	pending_= false;
+    }
+
+    // decay by the frame intervals elapsed since the last frame
+    const gint64 now= g_get_monotonic_time();
+    const double frames= faded_ ?
+	double(now - faded_) / (frame_interval * 1000.0) : 0.0;
+    faded_= now;
+    fade_(frames > 0.0 ? float(pow(decay_, frames)) : 1.0f);
+
+    Cairo::RefPtr<Cairo::SurfacePattern> pattern=
+	Cairo::SurfacePattern::create(surface_);
+    pattern->set_filter(Cairo::FILTER_NEAREST);
+
+    cr->save();
+    cr->translate(MIN(xMap.i1(), xMap.i2()) - 0.5,
+		  MIN(yMap.i1(), yMap.i2()) - 0.5);
+    cr->set_source(pattern);
+    cr->paint();
+    cr->restore();
+}
+
+/*! Add one sweep
+ *
+ *  The sweep is marked in a hit mask, which the next fade_() adds to
+ *  the history.
+ */
+void PersistenceCurve::add_sweep_(const DoubleIntMap &xMap,
+				  const DoubleIntMap &yMap,
+				  int from, int to)
+{
+    const int w= width_;
+    const int h= height_;
+    const int x0= MIN(xMap.i1(), xMap.i2());
+    const int y0= MIN(yMap.i1(), yMap.i2());
+    auto plot= [&](int x, int y) { hit_[y * w + x]= 1; };
+
+    const double *xs= x_column(xMap);
+    const double *ys= y_column(yMap);
+    double xp= 0.0, yp= 0.0;
+    bool open= false;
+    for (int i= from; i <= to; i++) {
+	const double xi= xMap.raw_x_transform(xs[i]) - x0;
+	const double yi= yMap.raw_x_transform(ys[i]) - y0;
+	if (xi != xi || yi != yi) {
+	    open= false;
+	    continue;
+	}
+	if (open)
+	    raster_segment(xp, yp, xi, yi, w, h, plot);
+	else
+	    raster_segment(xi, yi, xi, yi, w, h, plot);
+	xp= xi;
+	yp= yi;
+	open= true;
+    }
+}
+
+/*! Decay the history, add the hit mask and shade the result
+ *
+ *  A single pass over the buffer multiplies it by decay, adds and
+ *  clears the mask and shades the result into the image surface.
+ *  While any pixel is still shaded, a redraw is requested after one
+ *  frame interval, so that the trace keeps fading without new sweeps.
+ */
+void PersistenceCurve::fade_(float decay)
+{
+    const int w= width_;
+    const int h= height_;
+
+    // a pixel hit once per frame interval converges to 1/(1-decay)
+    const float norm= (1.0 - decay_) * (ColorMap::Size - 1);
+    bool visible= false;
+    surface_->flush();
+    unsigned char *data= surface_->get_data();
+    const int stride= surface_->get_stride();
+    for (int r= 0; r < h; ++r) {
+	uint32_t *row= reinterpret_cast<uint32_t *>(data + r * stride);
+	float *acc= &accum_[r * w];
+	uint8_t *hit= &hit_[r * w];
+	for (int c= 0; c < w; ++c) {
+	    const float a= acc[c] * decay + hit[c];
+	    acc[c]= a;
+	    hit[c]= 0;
+	    const int k= int(a * norm + 0.5f);
+	    visible|= k > 0;
+	    row[c]= colormap_.pixel(MIN(k, int(ColorMap::Size - 1)));
+	}
+    }
+    surface_->mark_dirty();
+
+    if (visible && !fade_timer_.connected())
+	fade_timer_= Glib::signal_timeout().connect(
+	    sigc::mem_fun(*this, &PersistenceCurve::on_fade_timeout_),
+	    frame_interval);
+}
+
+//! Requests the next frame of a fading trace
+bool PersistenceCurve::on_fade_timeout_()
+{
+    curve_changed();
+    return false;
+}
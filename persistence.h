@@ -0,0 +1,94 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_PERSISTENCE_H
+#define PLOTMM_PERSISTENCE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include <sigc++/sigc++.h>
+
+#include "curve.h"
+#include "colormap.h"
+
+namespace PlotMM {
+
+    /*! @brief A curve drawn like the trace of an analog oscilloscope
+     *
+     *  The data of a PersistenceCurve hold only the current sweep.
+     *  Whenever a new sweep is set with set_data(), the next draw()
+     *  adds the 1-px rasterized sweep to a float accumulation buffer.
+     *  Independently of the sweeps, every draw() multiplies the buffer
+     *  by decay() raised to the number of frame intervals elapsed since
+     *  the previous draw(), so the trace fades at the same speed
+     *  whether sweeps arrive fast, slowly or not at all.  While
+     *  anything is visible, the curve asks for a redraw every frame
+     *  interval.  The buffer is shaded through a ColorMap and painted
+     *  with a single blit, so the cost of a frame does not depend on
+     *  the number of sweeps still visible.
+     *
+     *  Changing the maps or the size of the canvas clears the history.
+     *
+     *  \sa Curve
+     */
+    class PersistenceCurve : public Curve
+    {
+    public:
+	PersistenceCurve(const Glib::ustring &title = "");
+	virtual ~PersistenceCurve();
+
+	void set_decay(double f);
+	//! Return the factor the history is multiplied with per frame interval
+	double decay() const { return decay_; }
+
+	//! Length of a frame interval in ms
+	static const int frame_interval= 16;
+
+	//! Return the colormap used to shade the history
+	ColorMap &colormap() { return colormap_; }
+
+	void clear_history();
+
+	virtual Glib::RefPtr<Curve> clone() const;
+	//! The history is updated by draw()
+	virtual bool concurrent_draw() const { return false; }
+
+	virtual void draw(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+			  const DoubleIntMap &xMap, const DoubleIntMap &yMap,
+			  int from = 0, int to = -1);
+
+    protected:
+	virtual void data_changed(int first);
+
+	virtual void add_sweep_(const DoubleIntMap &xMap,
+				const DoubleIntMap &yMap,
+				int from, int to);
+	void fade_(float decay);
+	bool on_fade_timeout_();
+
+    private:
+	PersistenceCurve(const PersistenceCurve &);
+	const PersistenceCurve& operator= (const PersistenceCurve &);
+
+	double decay_;
+	bool pending_;
+	gint64 faded_;
+	sigc::connection fade_timer_;
+	int width_, height_;
+	DoubleIntMap xMap_, yMap_;
+
+	std::vector<float> accum_;
+	std::vector<uint8_t> hit_;
+	ColorMap colormap_;
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+    };
+
+}
+
+#endif
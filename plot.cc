@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <sigc++/sigc++.h>
+#include <gdkmm/frameclock.h>
 #include <gdkmm/general.h> // set_source_pixbuf()
 
 #include <sys/time.h>
@@ -30,7 +31,7 @@
 #include <sstream>
 
 using namespace PlotMM;
-using std::istream;
+using std::istream;
 using std::iostream;
 
 
@@ -327,8 +328,20 @@ Plot::Plot() :
     bg_off(0),
     draw_select_(false),
     layout_(7,9),
-    curveidx_(-1)
-    
+    curveidx_(-1),
+    renderMode_(RENDER_DIRECT),
+    renderThread_(0),
+    updatePending_(false),
+    updateDepth_(0),
+    replotPending_(false),
+    selectionPending_(false),
+    tickId_(0),
+    lastFrame_(0),
+    frameRate_(0.0),
+    visibleY_(false),
+    qLo_(0.0),
+    qHi_(1.0),
+    aliased_(false)
 {
 //    add(m_box1);
 
@@ -384,18 +397,24 @@ Plot::Plot() :
     tickLabel_[2]->font()->set_size(int(fontsize*.8));
     tickLabel_[3]->font()->set_size(int(fontsize*.8));
 
+    background_.set_file("/Applications/Drumroaster/bg_1.png");
+    background_.signal_ready.connect(
+	sigc::mem_fun(canvas_, &Gtk::Widget::queue_draw));
 
 }
 
 
 Plot::~Plot()
 {
+    delete renderThread_;
 }
 
 /*! @brief Add a new curve to the plot
  *
  *  The plot will not be updated - call replot() manually after adding
- *  new curves.
+ *  new curves.  Later changes of the curve are tracked through
+ *  Curve::signal_curve_changed and only redraw the canvas, and the
+ *  scales if their autoscaled range changes.
  */
 int Plot::add_curve(const Glib::RefPtr<Curve> &cv,
 		   PlotAxisID xaxis,
@@ -405,8 +424,114 @@ int Plot::add_curve(const Glib::RefPtr<Curve> &cv,
     plotDict_[curveidx_].curve= cv;
     plotDict_[curveidx_].xaxis= xaxis;
     plotDict_[curveidx_].yaxis= yaxis;
+    plotDict_[curveidx_].aggregate= false;
+    plotDict_[curveidx_].dirty= false;
+    if (aliased_) cv->set_aliased(true);
+    cv->signal_curve_changed.connect(
+	sigc::bind(sigc::mem_fun(*this, &Plot::on_curve_changed_),
+		   curveidx_));
     return curveidx_;
 }
+
+/*! @brief Draw a curve as part of the plot's line density image
+ *
+ *  Aggregated curves are not stroked individually.  Instead, all of
+ *  them are rasterized into one accumulation buffer which counts how
+ *  many curves pass through each pixel, and that buffer is drawn
+ *  below the other curves using the colormap of line_density().
+ *  This is meant for overlaying thousands of similar traces.
+ *
+ *  \param id curve id as returned by add_curve()
+ *  \sa LineDensity
+ */
+void Plot::set_aggregated(int id, bool b)
+{
+    std::map<int,CurveInfo>::iterator cv= plotDict_.find(id);
+    if (cv == plotDict_.end() || cv->second.aggregate == b) return;
+    cv->second.aggregate= b;
+    invalidate_cache();
+}
+
+/*! Query if a curve is drawn as part of the line density image
+ */
+bool Plot::aggregated(int id) const
+{
+    std::map<int,CurveInfo>::const_iterator cv= plotDict_.find(id);
+    return cv != plotDict_.end() && cv->second.aggregate;
+}
+
+/*! @brief Draw all curves as aliased pixels
+ *
+ *  Sets Curve::set_aliased() of all curves of the plot, and of those
+ *  added later on.  Lines, sticks and dots are then written straight
+ *  into an image instead of being stroked by Cairo; the other curve
+ *  styles are not affected.  Single curves can still be switched
+ *  back afterwards.
+ */
+void Plot::set_aliased(bool b)
+{
+    aliased_= b;
+    std::map<int,CurveInfo>::iterator cv;
+    for (cv= plotDict_.begin(); cv != plotDict_.end(); ++cv)
+	cv->second.curve->set_aliased(b);
+}
+
+/*! @brief Select how the curves are drawn
+ *
+ *  With RENDER_DIRECT all curves are drawn by the Gtk main thread
+ *  while the canvas is exposed.  With RENDER_THREADED a RenderThread
+ *  draws copies of the curves into an image surface, and the canvas
+ *  only paints the latest complete surface and is redrawn when a
+ *  newer one is available.  Curves changing while the thread draws
+ *  thus never block the main loop; the image lags behind by the time
+ *  needed to draw it.  Curves which cannot be copied (see
+ *  Curve::clone()) and aggregated curves are still drawn directly.
+ *
+ *  With RENDER_LAYERED every curve is drawn into a layer of its own,
+ *  and the layers of all changed curves are drawn in parallel on the
+ *  ThreadPool before they are composited in the order the curves were
+ *  added.  A layer is only redrawn if its curve or the maps have
+ *  changed.  Every layer takes as much memory as a screenshot of the
+ *  canvas.
+ *
+ *  With RENDER_TILED the canvas is split into the tiles of
+ *  PlotCanvas::tiles(), which are drawn in parallel and kept until a
+ *  curve or a map changes.  This helps with large canvases where a
+ *  single curve takes long to rasterize, and an expose of a part of
+ *  the canvas only redraws the tiles within that part.  Curves which
+ *  do not allow Curve::concurrent_draw() are drawn directly.
+ *
+ *  \sa invalidate_cache()
+ */
+void Plot::set_render_mode(PlotRenderMode m)
+{
+    if (m == renderMode_) return;
+    renderMode_= m;
+    delete renderThread_;
+    renderThread_= 0;
+    layerCache_.update(std::vector<LayerCache::Item>(), 0, 0);
+    if (m == RENDER_THREADED) {
+	renderThread_= new RenderThread;
+	renderThread_->signal_ready.connect(
+	    sigc::mem_fun(canvas_, &Gtk::Widget::queue_draw));
+    }
+    canvas_.queue_draw();
+}
+
+/*! @brief Redraw all curves at the next expose
+ *
+ *  The threaded and layered render modes only redraw curves whose
+ *  Curve::serial() has changed.  Call this after changing attributes
+ *  which do not notify the curve, e.g. the colors of its paint().
+ */
+void Plot::invalidate_cache()
+{
+    if (renderThread_) renderThread_->invalidate();
+    layerCache_.invalidate();
+    lineDensity_.invalidate();
+    canvas_.tiles()->invalidate();
+    canvas_.queue_draw();
+}
 //  Don't want an on_draw() here as it will obscure the plot window after drawing.
 //  PlotCanvas::on_draw() is sufficient... confirmed... on_draw() for DrawingArea objects only
 /*
@@ -426,45 +551,267 @@ bool PlotCanvas::on_draw(const Cairo::RefPtr<Cairo::Context>&cr)
     return true;  //allow signal propagation
 }
 
+/*! Autoscale all axes for which Scale::autoscale() is set
+ *
+ *  \sa autoscale_axes_
+ */
 bool Plot::reset_autoscale()
 {
-        std::map<int,CurveInfo>::iterator cv;
-    int axis;
-    bool autoscale= false;
+    bool axes[4]= { true, true, true, true };
+    autoscale_axes_(axes);
+    return true;
+}
 
-// Note below that tickMark is a vector of *Scale and axis 0-3 are TOP, BOTTOM, LEFTand RIGHT.
-// so if any axis is marked for autoscale, begin_autoscale() is called on that axis
-// and the local variable autoscale is set to true.
+/*! Autoscale y axes to the samples within the visible x range
+ *
+ *  If set, a y axis is autoscaled to the samples whose x value lies
+ *  within the range of their x axis, as long as that x axis is not
+ *  autoscaled itself.  Zooming in on x then also zooms in on y.  The
+ *  extrema are found with Curve::y_extent().
+ */
+void Plot::set_autoscale_visible_y(bool b)
+{
+    if (b == visibleY_) return;
+    visibleY_= b;
+    replot();
+}
 
-    for (axis=0; axis<4; ++axis) {
-	if (tickMark_[axis]->autoscale()) {
-	    tickMark_[axis]->begin_autoscale();
-	    autoscale= true;
-	}
-    }
+/*! Autoscale y axes to quantiles of the y values
+ *
+ *  With e.g. lo = 0.005 and hi = 0.995, a y axis is autoscaled so that
+ *  it shows the central 99% of the samples of each curve, and single
+ *  spikes no longer squeeze the signal into a flat line.  The
+ *  quantiles are estimated with Curve::y_quantiles().  lo = 0 and
+ *  hi = 1, the default, use the exact extents.  The visible range mode
+ *  of set_autoscale_visible_y() takes precedence.
+ */
+void Plot::set_autoscale_quantiles(double lo, double hi)
+{
+    lo= value_limes(lo, 0.0, 1.0);
+    hi= value_limes(hi, 0.0, 1.0);
+    if (lo > hi) std::swap(lo, hi);
+    if (lo == qLo_ && hi == qHi_) return;
+    qLo_= lo;
+    qHi_= hi;
+    replot();
+}
 
-// if any axis is marked for autoscale then the following is carried out.
-    if (autoscale) {
-	for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
-	    if (!cv->second.curve->enabled()) continue;
-	    PlotAxisID xaxis= cv->second.xaxis;
-	    PlotAxisID yaxis= cv->second.yaxis;
-	    DoubleRect br= cv->second.curve->bounding_rect();
-	    tickMark_[xaxis]->autoscale(br.get_x1(),br.get_x2());
-	    tickMark_[yaxis]->autoscale(br.get_y1(),br.get_y2());
-	}
+/*! Autoscale the given axes from the enabled curves using them
+ *
+ *  The bounding rectangle of every curve is computed at most once.
+ *  \sa set_autoscale_visible_y
+ *
+ *  \param axes axes to be autoscaled, indexed by PlotAxisID; entries
+ *         are cleared unless the range of the axis has changed
+ */
+void Plot::autoscale_axes_(bool axes[4])
+{
+    std::map<int,CurveInfo>::iterator cv;
+    double d1[4], d2[4];
+    bool any= false;
+
+    for (int axis=0; axis<4; ++axis) {
+	axes[axis]= axes[axis] && tickMark_[axis]->autoscale();
+	if (!axes[axis]) continue;
+	d1[axis]= tickMark_[axis]->scale_map().d1();
+	d2[axis]= tickMark_[axis]->scale_map().d2();
+	tickMark_[axis]->begin_autoscale();
+	any= true;
+    }
+    if (!any) return;
 
-// This ends the autoscaling for all axes marked for autoscale.
-	for (axis=0; axis<4; ++axis) {
-	    if (tickMark_[axis]->autoscale()) {
-		tickMark_[axis]->end_autoscale();
+    for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.curve->enabled()) continue;
+	PlotAxisID xaxis= cv->second.xaxis;
+	PlotAxisID yaxis= cv->second.yaxis;
+	if (!axes[xaxis] && !axes[yaxis]) continue;
+	const Glib::RefPtr<Curve> &curve= cv->second.curve;
+	const bool xLog= tickMark_[xaxis]->scale_map().logarithmic();
+	const bool yLog= tickMark_[yaxis]->scale_map().logarithmic();
+	bool yDone= false;
+	if (axes[yaxis]) {
+	    double y1, y2;
+	    if (visibleY_ && !tickMark_[xaxis]->autoscale()) {
+		const DoubleIntMap &xm= tickMark_[xaxis]->scale_map();
+		double x1= xm.d1(), x2= xm.d2();
+		if (xm.logarithmic()) {
+		    x1= exp(x1);
+		    x2= exp(x2);
+		}
+		if (curve->y_extent(x1, x2, y1, y2))
+		    autoscale_y_(curve, yaxis, y1, y2);
+		yDone= true;
+	    } else if (qLo_ > 0.0 || qHi_ < 1.0) {
+		if (curve->y_quantiles(qLo_, qHi_, y1, y2))
+		    autoscale_y_(curve, yaxis, y1, y2);
+		yDone= true;
 	    }
 	}
+	if (!axes[xaxis] && yDone) continue;
+	// on log axes, non-positive values are not drawn and not scaled to
+	DoubleRect br= curve->bounding_rect(xLog, yLog);
+	if ((xLog || yLog) && !br.is_valid()) continue;
+	if (axes[xaxis]) tickMark_[xaxis]->autoscale(br.get_x1(),br.get_x2());
+	if (axes[yaxis] && !yDone)
+	    tickMark_[yaxis]->autoscale(br.get_y1(),br.get_y2());
+    }
+
+    for (int axis=0; axis<4; ++axis) {
+	if (!axes[axis]) continue;
+	tickMark_[axis]->end_autoscale();
+	axes[axis]= d1[axis] != tickMark_[axis]->scale_map().d1() ||
+	    d2[axis] != tickMark_[axis]->scale_map().d2();
+    }
+}
+
+/*! Extend the autoscale of a y axis by a range of y values
+ *
+ *  On a logarithmic axis, a non-positive lower bound is replaced by
+ *  the smallest positive y value of the curve.
+ */
+void Plot::autoscale_y_(const Glib::RefPtr<Curve> &curve, PlotAxisID yaxis,
+			double y1, double y2)
+{
+    if (y1 > y2) std::swap(y1, y2);
+    if (tickMark_[yaxis]->scale_map().logarithmic() && !(y1 > 0.0)) {
+	if (!(y2 > 0.0)) return;
+	y1= MIN(curve->bounding_rect(false, true).get_y1(), y2);
+    }
+    tickMark_[yaxis]->autoscale(y1,y2);
+}
+
+//! marks a curve as changed and schedules update_dirty_()
+void Plot::on_curve_changed_(int id)
+{
+    std::map<int,CurveInfo>::iterator cv= plotDict_.find(id);
+    if (cv == plotDict_.end()) return;
+    cv->second.dirty= true;
+    updatePending_= true;
+    schedule_update_();
+}
+
+/*! Invalidates what the changed curves affect
+ *
+ *  The axes of changed curves are autoscaled.  Only scales whose range
+ *  has changed are redrawn together with their labels; the canvas is
+ *  redrawn if any enabled curve has changed.
+ */
+void Plot::update_dirty_()
+{
+    std::map<int,CurveInfo>::iterator cv;
+    bool axes[4]= { false, false, false, false };
+    bool canvas= false;
+
+    updatePending_= false;
+    for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.dirty) continue;
+	cv->second.dirty= false;
+	if (!cv->second.curve->enabled()) continue;
+	axes[cv->second.xaxis]= axes[cv->second.yaxis]= true;
+	canvas= true;
+    }
+
+    autoscale_axes_(axes);
+    for (int axis=0; axis<4; ++axis) {
+	if (!axes[axis]) continue;
+	tickMark_[axis]->queue_draw();
+	tickLabel_[axis]->queue_draw();
+    }
+    if (canvas) canvas_.queue_draw();
+}
+
+//! makes on_tick_() run at the next frame of the canvas
+void Plot::schedule_update_()
+{
+    if (tickId_ || updateDepth_) return;
+    tickId_= canvas_.add_tick_callback(sigc::mem_fun(*this, &Plot::on_tick_));
+}
+
+/*! Carries out all updates requested so far
+ *
+ *  \return false if there was nothing to do
+ */
+bool Plot::flush_updates_()
+{
+    if (!updatePending_ && !replotPending_ && !selectionPending_)
+	return false;
+
+    if (replotPending_) {
+	replotPending_= false;
+	updatePending_= false;
+	for (std::map<int,CurveInfo>::iterator cv= plotDict_.begin();
+	     cv!=plotDict_.end(); ++cv)
+	    cv->second.dirty= false;
+	reset_autoscale();
+	// redraw everything and erase the drag rectangle, if present
+	if (!draw_select_) queue_draw();
+    }
+    if (updatePending_)
+	update_dirty_();
+    if (selectionPending_) {
+	selectionPending_= false;
+	canvas_.queue_draw();
+    }
+    return true;
+}
+
+/*! Carries out all updates requested since the last frame
+ *
+ *  Runs in the update phase of the frame clock, i.e. once per frame
+ *  before the widgets are drawn, so any number of replot() and
+ *  set_selection() calls and curve changes between two frames result
+ *  in one autoscale pass and one redraw.  The callback removes itself
+ *  when there is nothing to do, and during an update transaction,
+ *  which is flushed by commit_update().
+ */
+bool Plot::on_tick_(const Glib::RefPtr<Gdk::FrameClock> &clock)
+{
+    if (updateDepth_ || !flush_updates_()) {
+	tickId_= 0;
+	lastFrame_= 0;
+	return false;
+    }
 
-    } // end if (autoscale...
+    const gint64 now= clock->get_frame_time();
+    if (lastFrame_ && now > lastFrame_) {
+	const double rate= 1e6 / (now - lastFrame_);
+	frameRate_= frameRate_ > 0.0 ? 0.9 * frameRate_ + 0.1 * rate : rate;
+    }
+    lastFrame_= now;
     return true;
 }
 
+/*! @brief Start a batch of changes to curves and scales
+ *
+ *  Until the matching commit_update(), changes of the plot's curves
+ *  and calls of replot() are only recorded, and the scales defer
+ *  rebuilding their divisions (see Scale::freeze()).  Calls may be
+ *  nested.
+ *
+ *  \sa PlotUpdate
+ */
+void Plot::begin_update()
+{
+    if (updateDepth_++) return;
+    for (int axis=0; axis<4; ++axis)
+	tickMark_[axis]->freeze();
+}
+
+/*! @brief Finish a batch of changes started with begin_update()
+ *
+ *  The outermost commit merges the extents of all changed curves
+ *  once, rebuilds the division of every scale whose range changed
+ *  once and queues one redraw.
+ */
+void Plot::commit_update()
+{
+    if (!updateDepth_) return;
+    if (--updateDepth_) return;
+    flush_updates_();
+    for (int axis=0; axis<4; ++axis)
+	tickMark_[axis]->thaw();
+}
+
 /*! Replot all curves
  *
  *  After adding curves to the plot or changing the curves' data with
@@ -472,20 +819,17 @@ bool Plot::reset_autoscale()
  *
  *  If autoscaling is activated for an axis used by any of the
  *  Curve::enabled() curves that axis will be scaled to a new range.
+ *
+ *  The update is deferred to the next frame of the canvas, so calling
+ *  replot() more often than the display refreshes costs nothing.
+ *
+ *  \sa frame_rate()
  */
 bool Plot::replot()
 {
-    reset_autoscale();
-
-    if(!draw_select_)
-    {
-    // redraw everything and erase the
-    //  drag rectangle, if present.  Causes on_draw() for all widgets.
-
-    queue_draw();
-
-    }
-
+    // autoscaling and redrawing are done by on_tick_(), once per frame
+    replotPending_= true;
+    schedule_update_();
     return true;
 }
 
@@ -506,68 +850,191 @@ cr->save();
 // background image button in old roast data window.  The image can be toggled on and off by a button.
 //**********************
 
-    std::ifstream infile("/Applications/Drumroaster/bg_1.png");
-    if (infile.good() && draw_bg && !draw_expanded) {
+// The image is decoded once in the background and kept scaled to the canvas; see Background.
+    if (draw_bg && !draw_expanded)
+        background_.paint(cr, width, height, bg_off);
+//**********************
+
+    draw_aggregated_(cr);
+
+    if (renderMode_ == RENDER_THREADED)
+	draw_threaded_(cr);
+    else if (renderMode_ == RENDER_LAYERED)
+	draw_layered_(cr);
+    else if (renderMode_ == RENDER_TILED)
+	draw_tiled_(cr);
+    else for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.curve->enabled()) continue;
+	if (cv->second.aggregate) continue;
+	PlotAxisID xaxis= cv->second.xaxis;
+	PlotAxisID yaxis= cv->second.yaxis;
+
+//    Make sure that the transform matrix is set up properly
+    update_maps_(xaxis, yaxis);
 
-        image_ptr_ = Gdk::Pixbuf::create_from_file ("/Applications/Drumroaster/bg_1.png");
+//Bitter experience has shown that it is best not to store the Cairo::Context.  Pass it as argument
 
-        image_ptr_ = image_ptr_->scale_simple(width, height, Gdk::INTERP_BILINEAR);
+    cv->second.curve->draw(cr, canvas_.get_window(), tickMark_[xaxis]->scale_map(), tickMark_[yaxis]->scale_map());
 
+    }
 
-            Cairo::Format format = Cairo::FORMAT_RGB24;
-            if (image_ptr_->get_has_alpha())
-            {
-                format = Cairo::FORMAT_ARGB32;
-            }
+cr->restore();
 
-         // Create a new ImageSurface
-            Cairo::RefPtr< Cairo::ImageSurface > image_surface_ptr_ = Cairo::ImageSurface::create  (format, image_ptr_->get_width(), image_ptr_->get_height());
+if (draw_select_)draw_selection_(cr);
 
-            // Create the new Context for the ImageSurface
-            Cairo::RefPtr< Cairo::Context > image_context_ptr_ = Cairo::Context::create (image_surface_ptr_);
+canvas_.end_replot();
 
-            // Draw the image on the new Context
-            Gdk::Cairo::set_source_pixbuf (image_context_ptr_, image_ptr_, 0.0, 0.0);
-            image_context_ptr_->paint();
 
-            cr->set_source (image_surface_ptr_, bg_off, 0.0);
 
-            cr->paint_with_alpha(0.3);
-    }
-//**********************
+return true;
+
+
+}
+
+
+//! draws all aggregated curves as one line density image
+void Plot::draw_aggregated_(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    std::map<int,CurveInfo>::iterator cv;
+    std::vector<LineDensity::Trace> traces;
 
     for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.aggregate) continue;
 	if (!cv->second.curve->enabled()) continue;
 	PlotAxisID xaxis= cv->second.xaxis;
 	PlotAxisID yaxis= cv->second.yaxis;
 
-//    Make sure that the transform matrix is set up properly
-    int winx, winy, winw, winh;
+	update_maps_(xaxis, yaxis);
 
-    tickMark_[xaxis]->get_window()->get_geometry(winx, winy, winw, winh);
-    tickMark_[xaxis]->scale_map().set_int_range(0, winw-1);
-    tickMark_[yaxis]->get_window()->get_geometry(winx, winy, winw, winh);
-    tickMark_[yaxis]->scale_map().set_int_range(winh-1, 0);
+	LineDensity::Trace t;
+	t.curve= cv->second.curve.operator->();
+	t.xMap= tickMark_[xaxis]->scale_map();
+	t.yMap= tickMark_[yaxis]->scale_map();
+	traces.push_back(t);
+    }
+    if (traces.empty()) return;
 
-//Bitter experience has shown that it is best not to store the Cairo::Context.  Pass it as argument
+    Gtk::Allocation allocation = canvas_.get_allocation();
+    lineDensity_.update(traces, allocation.get_width(),
+			allocation.get_height());
+    lineDensity_.paint(cr);
+}
 
-    cv->second.curve->draw(cr, canvas_.get_window(), tickMark_[xaxis]->scale_map(), tickMark_[yaxis]->scale_map());
+/*! draws the latest surface of the render thread, requests a new one
+ *  if any curve or map has changed and draws the curves the thread
+ *  cannot draw
+ */
+void Plot::draw_threaded_(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    std::map<int,CurveInfo>::iterator cv;
+    std::vector<RenderThread::Item> items, rest;
+
+    for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.curve->enabled()) continue;
+	if (cv->second.aggregate) continue;
+	PlotAxisID xaxis= cv->second.xaxis;
+	PlotAxisID yaxis= cv->second.yaxis;
+
+	update_maps_(xaxis, yaxis);
 
+	RenderThread::Item it;
+	it.curve= cv->second.curve;
+	it.xMap= tickMark_[xaxis]->scale_map();
+	it.yMap= tickMark_[yaxis]->scale_map();
+	items.push_back(it);
     }
 
-cr->restore();
+    Gtk::Allocation allocation = canvas_.get_allocation();
+    renderThread_->request(items, allocation.get_width(),
+			   allocation.get_height(), rest);
 
-if (draw_select_)draw_selection_(cr);
+    Cairo::RefPtr<Cairo::ImageSurface> surface= renderThread_->surface();
+    if (surface) {
+	cr->save();
+	cr->set_source(surface, 0.0, 0.0);
+	cr->paint();
+	cr->restore();
+    }
 
-canvas_.end_replot();
+    for (unsigned int i= 0; i < rest.size(); ++i)
+	rest[i].curve->draw(cr, canvas_.get_window(), rest[i].xMap, rest[i].yMap);
+}
+
+/*! draws the curves as layers, redrawing only the layers which are out
+ *  of date
+ */
+void Plot::draw_layered_(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    std::map<int,CurveInfo>::iterator cv;
+    std::vector<LayerCache::Item> items;
+
+    for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.curve->enabled()) continue;
+	if (cv->second.aggregate) continue;
+	PlotAxisID xaxis= cv->second.xaxis;
+	PlotAxisID yaxis= cv->second.yaxis;
 
+	update_maps_(xaxis, yaxis);
 
+	LayerCache::Item it;
+	it.key= cv->first;
+	it.curve= cv->second.curve;
+	it.xMap= tickMark_[xaxis]->scale_map();
+	it.yMap= tickMark_[yaxis]->scale_map();
+	items.push_back(it);
+    }
 
-return true;
+    Gtk::Allocation allocation = canvas_.get_allocation();
+    layerCache_.update(items, allocation.get_width(),
+		       allocation.get_height());
+    layerCache_.paint(cr);
+}
 
+/*! draws the curves through the tile cache of the canvas and the
+ *  curves which cannot be drawn by several threads on top
+ */
+void Plot::draw_tiled_(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    std::map<int,CurveInfo>::iterator cv;
+    std::vector<TileCache::Item> items, rest;
+
+    for (cv= plotDict_.begin(); cv!=plotDict_.end(); ++cv) {
+	if (!cv->second.curve->enabled()) continue;
+	if (cv->second.aggregate) continue;
+	PlotAxisID xaxis= cv->second.xaxis;
+	PlotAxisID yaxis= cv->second.yaxis;
 
+	update_maps_(xaxis, yaxis);
+
+	TileCache::Item it;
+	it.curve= cv->second.curve;
+	it.xMap= tickMark_[xaxis]->scale_map();
+	it.yMap= tickMark_[yaxis]->scale_map();
+	if (it.curve->concurrent_draw())
+	    items.push_back(it);
+	else
+	    rest.push_back(it);
+    }
+
+    Gtk::Allocation allocation = canvas_.get_allocation();
+    canvas_.tiles()->update(items, allocation.get_width(),
+			    allocation.get_height());
+    canvas_.tiles()->paint(cr);
+
+    for (unsigned int i= 0; i < rest.size(); ++i)
+	rest[i].curve->draw(cr, canvas_.get_window(), rest[i].xMap, rest[i].yMap);
 }
 
+//! sets the integer ranges of the maps of both axes to the canvas size
+void Plot::update_maps_(PlotAxisID xaxis, PlotAxisID yaxis)
+{
+    int winx, winy, winw, winh;
+
+    tickMark_[xaxis]->get_window()->get_geometry(winx, winy, winw, winh);
+    tickMark_[xaxis]->scale_map().set_int_range(0, winw-1);
+    tickMark_[yaxis]->get_window()->get_geometry(winx, winy, winw, winh);
+    tickMark_[yaxis]->scale_map().set_int_range(winh-1, 0);
+}
 
 /*! Set the selection to the given rectangle.  If selection is
  *  enabled, the old rectangle is erased and the new is drawn.  Note
@@ -581,7 +1048,9 @@ void Plot::set_selection(const PlotMM::Rectangle &r)
     select_= r;
     //hide();
     //show_all();
-    queue_draw();
+    // only the canvas shows the selection; redrawn by on_tick_()
+    selectionPending_= true;
+    schedule_update_();
     //if (draw_select_) draw_selection_();
 }
 
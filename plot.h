@@ -24,6 +24,11 @@
 #include "scale.h"
 #include "rectangle.h"
 #include "doubleintmap.h"
+#include "linedensity.h"
+#include "renderthread.h"
+#include "layercache.h"
+#include "tilecache.h"
+#include "background.h"
 
 
 namespace Gdk {
@@ -106,6 +111,9 @@ class PlotCanvas : public Gtk::DrawingArea
 	virtual void clear();
 	virtual void end_replot();
 
+	//! Return the tiles curves are drawn into with RENDER_TILED
+	TileCache *tiles() { return &tiles_; }
+
     protected:
     virtual bool on_draw(const Cairo::RefPtr<Cairo::Context>&cr);
 	virtual void on_realize();
@@ -116,6 +124,7 @@ class PlotCanvas : public Gtk::DrawingArea
 	Gdk::Color black_, grey_, white_;
 
 	Plot* plot_ptr;
+	TileCache tiles_;
     };
 
     /*! brief Class relating a curve to a plot.
@@ -140,6 +149,17 @@ class PlotCurve
 	AXIS_RIGHT
     };
 
+    /*! @brief defines how the curves of a plot are drawn
+     *  \sa Plot::set_render_mode
+     */
+    enum PlotRenderMode
+    {
+	RENDER_DIRECT,
+	RENDER_THREADED,
+	RENDER_LAYERED,
+	RENDER_TILED
+    };
+
     /*! @brief Class implementing a plot widget.
      *
      */
@@ -155,12 +175,39 @@ class Plot : public Gtk::Frame
 		     bool enable= true);
 
 	bool replot();
+	void begin_update();
+	void commit_update();
+	//! Return the rate at which updates have recently been drawn (Hz)
+	double frame_rate() const { return frameRate_; }
 	bool replot2(const Cairo::RefPtr<Cairo::Context> &);
 	bool reset_autoscale();
+	void set_autoscale_visible_y(bool b);
+	//! Query if y axes are autoscaled to the visible x range only
+	bool autoscale_visible_y() const { return visibleY_; }
+	void set_autoscale_quantiles(double lo, double hi);
+	//! Return the lower quantile y axes are autoscaled to
+	double autoscale_lower_quantile() const { return qLo_; }
+	//! Return the upper quantile y axes are autoscaled to
+	double autoscale_upper_quantile() const { return qHi_; }
+
+	void set_aggregated(int id, bool b);
+	bool aggregated(int id) const;
+	void set_aliased(bool b);
+	//! Query if curves added from now on are drawn as aliased pixels
+	bool aliased() const { return aliased_; }
+
+	void set_render_mode(PlotRenderMode m);
+	//! Return how the curves are drawn
+	PlotRenderMode render_mode() const { return renderMode_; }
+	void invalidate_cache();
+	//! Return the line density image aggregated curves are drawn into
+	LineDensity *line_density() { return &lineDensity_; }
 
     TestArea *myarea() {return &myarea_;}
     PlotCanvas *canvas() {return &canvas_;}
 	PlotLabel *title() { return &title_; }
+	//! Return the image drawn behind the curves if draw_bg is set
+	Background *background() { return &background_; }
 	Scale *scale(PlotAxisID id) { return tickMark_[id]; }
 	PlotLabel *label(PlotAxisID id) { return axisLabel_[id]; }
 
@@ -189,6 +236,20 @@ class Plot : public Gtk::Frame
 	
 
     virtual void draw_selection_(const Cairo::RefPtr<Cairo::Context> &cr);
+	virtual void draw_aggregated_(const Cairo::RefPtr<Cairo::Context> &cr);
+	virtual void draw_threaded_(const Cairo::RefPtr<Cairo::Context> &cr);
+	virtual void draw_layered_(const Cairo::RefPtr<Cairo::Context> &cr);
+	virtual void draw_tiled_(const Cairo::RefPtr<Cairo::Context> &cr);
+	void update_maps_(PlotAxisID xaxis, PlotAxisID yaxis);
+	void autoscale_axes_(bool axes[4]);
+	void autoscale_y_(const Glib::RefPtr<Curve> &curve, PlotAxisID yaxis,
+			  double y1, double y2);
+
+	virtual void on_curve_changed_(int id);
+	virtual void update_dirty_();
+	void schedule_update_();
+	bool flush_updates_();
+	virtual bool on_tick_(const Glib::RefPtr<Gdk::FrameClock> &clock);
     private:
 
 	int loop;
@@ -200,9 +261,53 @@ class Plot : public Gtk::Frame
 	    Glib::RefPtr<Curve> curve;
 	    PlotAxisID xaxis;
 	    PlotAxisID yaxis;
+	    bool aggregate;
+	    bool dirty;
 	};
 
 	std::map<int,CurveInfo> plotDict_;
+	LineDensity lineDensity_;
+	Background background_;
+	PlotRenderMode renderMode_;
+	RenderThread *renderThread_;
+	LayerCache layerCache_;
+	bool updatePending_;
+	int updateDepth_;
+	bool replotPending_;
+	bool selectionPending_;
+	guint tickId_;
+	gint64 lastFrame_;
+	double frameRate_;
+	bool visibleY_;
+	double qLo_, qHi_;
+	bool aliased_;
+    };
+
+    /*! @brief Scoped update transaction of a Plot
+     *
+     *  Calls Plot::begin_update() on construction and
+     *  Plot::commit_update() on destruction.
+     *
+     *  \par Example:
+     *  \verbatim
+     {
+	 PlotUpdate update(plot);
+	 for (int i= 0; i < 60; ++i)
+	     curve[i]->set_data(x[i], y[i], n);
+     }  // one autoscale and one redraw here
+     \endverbatim
+     */
+    class PlotUpdate
+    {
+    public:
+	PlotUpdate(Plot &p) : plot_(p) { plot_.begin_update(); }
+	~PlotUpdate() { plot_.commit_update(); }
+
+    private:
+	PlotUpdate(const PlotUpdate &);
+	PlotUpdate &operator=(const PlotUpdate &);
+
+	Plot &plot_;
     };
 
 }
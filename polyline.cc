@@ -0,0 +1,261 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <math.h>
+
+#include "polyline.h"
+#include "raster.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+/*!
+  \brief Constructor
+  \param cr context the path is built in
+  \param byRow collapse pixel rows instead of pixel columns
+*/
+PolylineSink::PolylineSink(const Cairo::RefPtr<Cairo::Context> &cr,
+			   bool byRow) :
+    cr_(cr),
+    byRow_(byRow),
+    open_(false),
+    emitted_(0),
+    chunk_(0),
+    inChunk_(0),
+    vx_(0), vy_(0),
+    a_(0),
+    first_(0), lo_(0), hi_(0), last_(0),
+    clip_(false),
+    cx1_(0.0), cy1_(0.0), cx2_(0.0), cy2_(0.0),
+    started_(false),
+    atPrev_(false),
+    px_(0.0), py_(0.0)
+{
+}
+
+/*!
+  \brief Clip vertices given as doubles to a rectangle
+
+  Usually the rectangle is the visible part of the canvas grown by the
+  line width, so that clipping does not change what is drawn.
+  \sa clip_to_context
+*/
+void PolylineSink::set_clip(double x1, double y1, double x2, double y2)
+{
+    clip_= true;
+    cx1_= MIN(x1, x2);
+    cx2_= MAX(x1, x2);
+    cy1_= MIN(y1, y2);
+    cy2_= MAX(y1, y2);
+}
+
+/*!
+  \brief Clip to the clip extents of the context grown by margin
+*/
+void PolylineSink::clip_to_context(double margin)
+{
+    double x1, y1, x2, y2;
+    cr_->get_clip_extents(x1, y1, x2, y2);
+    set_clip(x1 - margin, y1 - margin, x2 + margin, y2 + margin);
+}
+
+/*!
+  \brief Stroke the path every n vertices
+
+  Whenever the current sub-path has reached n vertices, the path is
+  stroked with the current settings of the context and a new sub-path
+  is started at the vertex before the last one.  The chunks thus
+  overlap by one segment: the join at either end of that segment is
+  drawn by one of them, and its butt caps lie within the other chunk.
+  The caller strokes the remainder after flush() as usual.  Only use
+  this for paths which are stroked, not filled.
+
+  Since the overlapping segment is painted twice, a translucent pen
+  would show it darker, and round or square caps would stick out at
+  sharp turns.  Unless the source of the context is an opaque color
+  and the line cap is Cairo::LINE_CAP_BUTT when the first chunk is
+  complete, the path is not split at all.
+
+  \param n vertices per chunk, 0 to build a single path
+*/
+void PolylineSink::set_chunk(int n)
+{
+    chunk_= n > 1 ? n : 0;
+}
+
+/*!
+  \brief Start a new sub-path at (x, y)
+
+  Without a clip rectangle, the vertex is rounded to pixels.  With
+  one, the sub-path only starts where the next segment enters the
+  rectangle.
+*/
+void PolylineSink::move_to(double x, double y)
+{
+    if (!clip_) {
+	move_to(ROUND(x), ROUND(y));
+	return;
+    }
+    flush();
+    px_= x;
+    py_= y;
+    started_= true;
+    atPrev_= false;
+}
+
+/*!
+  \brief Extend the current sub-path to (x, y)
+
+  With a clip rectangle, only the part of the segment from the
+  previous vertex that lies within the rectangle is added.  Vertices
+  which are not finite end the sub-path.
+*/
+void PolylineSink::line_to(double x, double y)
+{
+    if (!clip_) {
+	line_to(ROUND(x), ROUND(y));
+	return;
+    }
+    if (!started_) {
+	move_to(x, y);
+	return;
+    }
+
+    double x0= px_, y0= py_, x1= x, y1= y, t0, t1;
+    px_= x;
+    py_= y;
+    if (!clip_segment(x0, y0, x1, y1, cx1_, cy1_, cx2_, cy2_, t0, t1)) {
+	atPrev_= false;
+	return;
+    }
+    if (!atPrev_ || t0 > 0.0)
+	move_to(ROUND(x0), ROUND(y0));
+    line_to(ROUND(x1), ROUND(y1));
+    atPrev_= (t1 == 1.0);
+}
+
+/*!
+  \brief Start a new sub-path at (x, y)
+
+  A pending span of the previous sub-path is emitted first.
+*/
+void PolylineSink::move_to(int x, int y)
+{
+    flush();
+    cr_->move_to(x, y);
+    ++emitted_;
+    inChunk_= 1;
+    vx_= x;
+    vy_= y;
+    a_= byRow_ ? y : x;
+    first_= lo_= hi_= last_= byRow_ ? x : y;
+    open_= true;
+}
+
+/*!
+  \brief Extend the current sub-path to (x, y)
+
+  Vertices in the same pixel column as the previous one only update
+  the pending span.  If no sub-path has been started, this acts like
+  move_to().
+*/
+void PolylineSink::line_to(int x, int y)
+{
+    if (!open_) {
+	move_to(x, y);
+	return;
+    }
+    const int a= byRow_ ? y : x;
+    const int b= byRow_ ? x : y;
+    if (a == a_) {
+	lo_= MIN(lo_, b);
+	hi_= MAX(hi_, b);
+	last_= b;
+	return;
+    }
+    emit_span_();
+    emit_(a, b);
+    a_= a;
+    first_= lo_= hi_= last_= b;
+}
+
+/*!
+  \brief Emit the pending span
+
+  Must be called before the path is stroked or filled.  The sink
+  can be used for further sub-paths afterwards.
+*/
+void PolylineSink::flush()
+{
+    atPrev_= false;
+    if (!open_) return;
+    emit_span_();
+    open_= false;
+}
+
+//! Append one vertex given in (collapsed, span) coordinates
+void PolylineSink::emit_(int a, int b)
+{
+    const int x= byRow_ ? b : a;
+    const int y= byRow_ ? a : b;
+    cr_->line_to(x, y);
+    ++emitted_;
+    if (chunk_ && ++inChunk_ >= chunk_) {
+	if (may_split_()) {
+	    // the next chunk repeats the last segment
+	    cr_->stroke();
+	    cr_->move_to(vx_, vy_);
+	    cr_->line_to(x, y);
+	    emitted_+= 2;
+	    inChunk_= 2;
+	} else
+	    chunk_= 0;
+    }
+    vx_= x;
+    vy_= y;
+}
+
+//! Query if splitting the path cannot change what is drawn
+bool PolylineSink::may_split_() const
+{
+    if (cr_->get_line_cap() != Cairo::LINE_CAP_BUTT) return false;
+    Cairo::RefPtr<Cairo::SolidPattern> pen=
+	Cairo::RefPtr<Cairo::SolidPattern>::cast_dynamic(cr_->get_source());
+    if (!pen) return false;
+    double r, g, b, a;
+    pen->get_rgba(r, g, b, a);
+    return a >= 1.0;
+}
+
+/*!
+  \brief Emit the pending span of the current column
+
+  The path currently ends at first_.  The span is covered by visiting
+  the extreme values and then the last value, skipping all steps of
+  zero length.
+*/
+void PolylineSink::emit_span_()
+{
+    if (lo_ == hi_) return;
+
+    int cur= first_;
+    if (last_ == lo_) {
+	if (hi_ != cur) { emit_(a_, hi_); cur= hi_; }
+	if (lo_ != cur) emit_(a_, lo_);
+    }
+    else if (last_ == hi_) {
+	if (lo_ != cur) { emit_(a_, lo_); cur= lo_; }
+	if (hi_ != cur) emit_(a_, hi_);
+    }
+    else {
+	if (lo_ != cur) emit_(a_, lo_);
+	emit_(a_, hi_);
+	emit_(a_, last_);
+    }
+    lo_= hi_= first_= last_;
+}
@@ -0,0 +1,111 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_POLYLINE_H
+#define PLOTMM_POLYLINE_H
+
+#include <cairomm/context.h>
+
+namespace PlotMM {
+
+    /*! @brief Stream polyline vertices into a Cairo path
+     *
+     *  The sink receives the vertices of a polyline one at a time and
+     *  only keeps the last one.  Consecutive vertices that fall into
+     *  the same pixel column are collapsed into one vertical span
+     *  (lowest, highest and last value), so the number of path
+     *  elements handed to Cairo is bounded by the width of the canvas
+     *  rather than by the number of samples.  For curves drawn as
+     *  x = f(y) the sink collapses pixel rows instead.
+     *
+     *  The sink only builds the path.  Stroking or filling is left to
+     *  the caller after flush() has been called.
+     *
+     *  Vertices given as doubles can be clipped against a rectangle,
+     *  see set_clip().  Each segment is clipped with the Liang-Barsky
+     *  algorithm before it is rounded to pixels, so points far off the
+     *  canvas never reach Cairo and never overflow an int.  Runs of
+     *  segments outside the rectangle are dropped; the path is
+     *  continued with a new sub-path where the polyline enters the
+     *  rectangle again.
+     *
+     *  Long paths can be stroked in chunks, see set_chunk().  Cairo's
+     *  stroker does not scale linearly with the length of a path that
+     *  crosses itself many times, whereas many short paths with the
+     *  same total length cost a predictable amount each.  Consecutive
+     *  chunks overlap by one segment, so every join is drawn, but that
+     *  segment is painted twice.  Chunking is therefore only done for
+     *  opaque solid pens with butt caps, where this cannot be seen
+     *  apart from slightly denser antialiased edges of the segment.
+     *
+     *  \par Example:
+     *  \verbatim
+     PolylineSink sink(cr);
+     sink.move_to(x0, y0);
+     for (i = 1; i < n; i++)
+	 sink.line_to(x[i], y[i]);
+     sink.flush();
+     cr->stroke();
+     \endverbatim
+     */
+    class PolylineSink
+    {
+    public:
+	PolylineSink(const Cairo::RefPtr<Cairo::Context> &cr,
+		     bool byRow = false);
+
+	void move_to(int x, int y);
+	void line_to(int x, int y);
+	void move_to(double x, double y);
+	void line_to(double x, double y);
+	void flush();
+
+	void set_clip(double x1, double y1, double x2, double y2);
+	void clip_to_context(double margin);
+
+	void set_chunk(int n);
+	//! Return the number of vertices after which the path is stroked
+	int chunk() const { return chunk_; }
+
+	//! Return the number of vertices actually passed on to Cairo
+	int emitted() const { return emitted_; }
+
+    private:
+	void emit_(int a, int b);
+	void emit_span_();
+	bool may_split_() const;
+
+	Cairo::RefPtr<Cairo::Context> cr_;
+	bool byRow_;
+	bool open_;
+	int emitted_;
+
+	// chunked stroking: vertices per chunk (0 = off) and vertices
+	// in the current chunk
+	int chunk_;
+	int inChunk_;
+
+	// the last vertex passed to Cairo
+	int vx_, vy_;
+
+	// pending span: a is the collapsed coordinate, b runs along
+	// the span
+	int a_;
+	int first_, lo_, hi_, last_;
+
+	// clipping of double vertices: the rectangle, the previous
+	// vertex and whether the path currently ends there
+	bool clip_;
+	double cx1_, cy1_, cx2_, cy2_;
+	bool started_, atPrev_;
+	double px_, py_;
+    };
+
+}
+
+#endif
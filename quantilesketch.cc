@@ -0,0 +1,116 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <algorithm>
+#include <math.h>
+
+#include "quantilesketch.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+/*! Constructor
+ *
+ *  \param k size of the top level compactor; larger values are more
+ *         accurate and need more memory
+ */
+QuantileSketch::QuantileSketch(int k) :
+    k_(MAX(k, 8)),
+    count_(0),
+    seed_(2463534242u),
+    levels_(1),
+    sortedValid_(false)
+{
+}
+
+//! Forget all values
+void QuantileSketch::clear()
+{
+    levels_.assign(1, std::vector<double>());
+    count_= 0;
+    sortedValid_= false;
+}
+
+//! Add a value
+void QuantileSketch::insert(double v)
+{
+    if (v != v) return;
+    if (!count_ || v < min_) min_= v;
+    if (!count_ || v > max_) max_= v;
+    levels_[0].push_back(v);
+    ++count_;
+    sortedValid_= false;
+    if ((int)levels_[0].size() >= capacity_(0))
+	compress_();
+}
+
+//! Return the capacity of a level; lower levels are smaller
+int QuantileSketch::capacity_(int level) const
+{
+    const int depth= levels_.size() - 1 - level;
+    return MAX(2, int(ceil(k_ * pow(2.0/3.0, depth))));
+}
+
+//! Halve the full levels, from the bottom up
+void QuantileSketch::compress_()
+{
+    for (unsigned int h= 0; h < levels_.size(); ++h) {
+	if ((int)levels_[h].size() < capacity_(h)) continue;
+	if (h + 1 == levels_.size())
+	    levels_.push_back(std::vector<double>());
+	std::vector<double> &lv= levels_[h];
+	std::vector<double> &up= levels_[h+1];
+	std::sort(lv.begin(), lv.end());
+
+	// an odd value stays on this level
+	const int n= lv.size() & ~1;
+	seed_^= seed_ << 13;
+	seed_^= seed_ >> 17;
+	seed_^= seed_ << 5;
+	for (int i= (seed_ >> 7) & 1; i < n; i+= 2)
+	    up.push_back(lv[i]);
+	lv.erase(lv.begin(), lv.begin() + n);
+    }
+}
+
+/*! Return the approximate q quantile, 0 <= q <= 1
+ *
+ *  The 0 and 1 quantiles are the exact minimum and maximum.  The
+ *  sorted summary is kept until the next insert(), so querying several
+ *  quantiles in a row costs one sort.  Returns NaN if no value has
+ *  been inserted.
+ */
+double QuantileSketch::quantile(double q) const
+{
+    if (!count_) return NAN;
+    if (q <= 0.0) return min_;
+    if (q >= 1.0) return max_;
+
+    if (!sortedValid_) {
+	sorted_.clear();
+	double w= 1.0;
+	for (unsigned int h= 0; h < levels_.size(); ++h, w*= 2.0)
+	    for (unsigned int i= 0; i < levels_[h].size(); ++i)
+		sorted_.push_back(std::make_pair(levels_[h][i], w));
+	std::sort(sorted_.begin(), sorted_.end());
+	double sum= 0.0;
+	for (unsigned int i= 0; i < sorted_.size(); ++i)
+	    sorted_[i].second= (sum+= sorted_[i].second);
+	sortedValid_= true;
+    }
+    const double rank= q * sorted_.back().second;
+    std::vector<std::pair<double,double> >::const_iterator it=
+	std::lower_bound(sorted_.begin(), sorted_.end(),
+			 std::make_pair(-HUGE_VAL, rank),
+			 [](const std::pair<double,double> &a,
+			    const std::pair<double,double> &b) {
+			     return a.second < b.second;
+			 });
+    if (it == sorted_.end()) --it;
+    return it->first;
+}
@@ -0,0 +1,55 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_QUANTILESKETCH_H
+#define PLOTMM_QUANTILESKETCH_H
+
+#include <vector>
+#include <utility>
+
+namespace PlotMM {
+
+    /*! @brief Approximate quantiles of a stream of values
+     *
+     *  A KLL sketch: values are collected in a hierarchy of compactors.
+     *  When a compactor is full, it is sorted and every other value is
+     *  passed on to the next level, where it counts twice.  The memory
+     *  is bounded by about 3 k values, insert() costs O(1) amortized,
+     *  and the rank error of quantile() is roughly 1.7 / k.
+     *  NaN values are ignored.
+     */
+    class QuantileSketch
+    {
+    public:
+	QuantileSketch(int k = 200);
+
+	void insert(double v);
+	void clear();
+	//! Return the number of values inserted since clear()
+	long long count() const { return count_; }
+
+	double quantile(double q) const;
+
+    private:
+	int capacity_(int level) const;
+	void compress_();
+
+	int k_;
+	long long count_;
+	double min_, max_;
+	unsigned int seed_;  // xorshift state choosing the kept half
+	std::vector<std::vector<double> > levels_;
+
+	// values with their cumulative weight, built by quantile()
+	mutable std::vector<std::pair<double,double> > sorted_;
+	mutable bool sortedValid_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <limits>
+
+#include "rangeindex.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+static const double inf= std::numeric_limits<double>::infinity();
+
+//! Constructor
+RangeIndex::RangeIndex() :
+    size_(0),
+    leaves_(0)
+{
+}
+
+//! Drop the index
+void RangeIndex::clear()
+{
+    size_= leaves_= 0;
+    min_.clear();
+    max_.clear();
+}
+
+/*! Bring the index up to date
+ *
+ *  \param data the indexed values
+ *  \param size number of values
+ *  \param first values before this index are unchanged since the
+ *         last call
+ */
+void RangeIndex::update(const double *data, int size, int first)
+{
+    const int blocks= (size + Block - 1) / Block;
+    if (first <= 0 || size < size_ || blocks > leaves_) {
+	// everything is recomputed, with room for the data to grow
+	int n= 1;
+	while (n < blocks) n<<= 1;
+	leaves_= n;
+	min_.assign(2 * n, inf);
+	max_.assign(2 * n, -inf);
+	first= 0;
+    }
+    size_= size;
+    if (!blocks) return;
+    first= MIN(first, size);
+
+    // leaves of the changed blocks
+    int lo= first / Block, hi= blocks - 1;
+    for (int b= lo; b <= hi; ++b) {
+	double mn= inf, mx= -inf;
+	scan_(data, b * Block, MIN(size, (b + 1) * Block) - 1, mn, mx);
+	min_[leaves_ + b]= mn;
+	max_[leaves_ + b]= mx;
+    }
+
+    // their parents, level by level
+    lo+= leaves_;
+    hi+= leaves_;
+    while (lo > 1) {
+	lo>>= 1;
+	hi>>= 1;
+	for (int i= lo; i <= hi; ++i) {
+	    min_[i]= MIN(min_[2*i], min_[2*i+1]);
+	    max_[i]= MAX(max_[2*i], max_[2*i+1]);
+	}
+    }
+}
+
+/*! Find the extrema of data[from..to]
+ *
+ *  \return false if the range holds no values other than NaN
+ */
+bool RangeIndex::extrema(const double *data, int from, int to,
+			 double &min, double &max) const
+{
+    from= MAX(from, 0);
+    to= MIN(to, size_ - 1);
+    min= inf;
+    max= -inf;
+    if (from > to) return false;
+
+    const int bf= from / Block, bt= to / Block;
+    if (bt - bf < 2) {
+	scan_(data, from, to, min, max);
+	return min <= max;
+    }
+
+    scan_(data, from, (bf + 1) * Block - 1, min, max);
+    scan_(data, bt * Block, to, min, max);
+
+    // full blocks bf+1 .. bt-1, bottom up
+    int l= leaves_ + bf + 1, r= leaves_ + bt - 1;
+    while (l <= r) {
+	if (l & 1) {
+	    min= MIN(min, min_[l]);
+	    max= MAX(max, max_[l]);
+	    ++l;
+	}
+	if (!(r & 1)) {
+	    min= MIN(min, min_[r]);
+	    max= MAX(max, max_[r]);
+	    --r;
+	}
+	l>>= 1;
+	r>>= 1;
+    }
+    return min <= max;
+}
+
+//! Extend min and max by data[from..to], skipping NaN
+void RangeIndex::scan_(const double *data, int from, int to,
+		       double &min, double &max) const
+{
+    for (int i= from; i <= to; ++i) {
+	const double v= data[i];
+	if (v < min) min= v;
+	if (v > max) max= v;
+    }
+}
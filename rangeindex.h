@@ -0,0 +1,57 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_RANGEINDEX_H
+#define PLOTMM_RANGEINDEX_H
+
+#include <vector>
+
+namespace PlotMM {
+
+    /*! @brief Minimum and maximum of any index range of a sequence
+     *
+     *  The sequence is divided into blocks of block_size() values.  A
+     *  segment tree over the blocks holds their minima and maxima, so
+     *  the extrema of a range are found in O(log n) plus a scan of the
+     *  partial blocks at both ends.  NaN values are ignored.
+     *
+     *  update() only recomputes the blocks from a given index on, so
+     *  appending samples costs time proportional to the new samples.
+     *  The index does not keep a pointer to the data; the caller has to
+     *  pass the same data to update() and extrema().
+     */
+    class RangeIndex
+    {
+    public:
+	RangeIndex();
+
+	void update(const double *data, int size, int first = 0);
+	void clear();
+	//! Return the number of values indexed
+	int size() const { return size_; }
+
+	bool extrema(const double *data, int from, int to,
+		     double &min, double &max) const;
+
+	//! Return the number of values summarized by a leaf
+	static int block_size() { return Block; }
+
+    private:
+	enum { Block = 32 };
+
+	void scan_(const double *data, int from, int to,
+		   double &min, double &max) const;
+
+	int size_;
+	int leaves_;  // number of leaves, a power of two
+	std::vector<double> min_, max_;
+    };
+
+}
+
+#endif
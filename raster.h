@@ -0,0 +1,167 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_RASTER_H
+#define PLOTMM_RASTER_H
+
+#include <math.h>
+
+#include "supplemental.h"
+
+namespace PlotMM {
+
+    /*! Visit the pixels of a 1-px aliased line (Bresenham)
+     *
+     *  plot(x, y) is called for every pixel from (x0, y0) to (x1, y1)
+     *  which lies inside [0,width) x [0,height).  Lines entirely on
+     *  one side of that rectangle are rejected without being walked.
+     *
+     *  \param plot functor taking two int arguments
+     */
+    template <class F>
+    void raster_line(int x0, int y0, int x1, int y1,
+		     int width, int height, F plot)
+    {
+	if ((x0 < 0 && x1 < 0) || (x0 >= width && x1 >= width) ||
+	    (y0 < 0 && y1 < 0) || (y0 >= height && y1 >= height))
+	    return;
+
+	const int dx= ABS(x1 - x0);
+	const int dy= -ABS(y1 - y0);
+	const int sx= x0 < x1 ? 1 : -1;
+	const int sy= y0 < y1 ? 1 : -1;
+	int err= dx + dy;
+	for (;;) {
+	    if (x0 >= 0 && x0 < width && y0 >= 0 && y0 < height)
+		plot(x0, y0);
+	    if (x0 == x1 && y0 == y1) break;
+	    const int e2= 2 * err;
+	    if (e2 >= dy) { err+= dy; x0+= sx; }
+	    if (e2 <= dx) { err+= dx; y0+= sy; }
+	}
+    }
+
+    /*! Clip a segment to a rectangle (Liang-Barsky)
+     *
+     *  The end points are moved onto the border of the rectangle
+     *  [left,right] x [top,bottom] where the segment leaves it, so the
+     *  slope of the remaining part is kept exactly.
+     *
+     *  \param t0 returns the parameter of the clipped start, 0 if the
+     *         start lies within the rectangle
+     *  \param t1 returns the parameter of the clipped end, 1 if the end
+     *         lies within the rectangle
+     *  \return false if no part of the segment lies within the
+     *          rectangle or an end point is not finite
+     */
+    inline bool clip_segment(double &x0, double &y0, double &x1, double &y1,
+			     double left, double top, double right, double bottom,
+			     double &t0, double &t1)
+    {
+	if (!(isfinite(x0) && isfinite(y0) && isfinite(x1) && isfinite(y1)))
+	    return false;
+
+	const double dx= x1 - x0, dy= y1 - y0;
+	const double p[4]= { -dx, dx, -dy, dy };
+	const double q[4]= { x0 - left, right - x0, y0 - top, bottom - y0 };
+	const double edge[4]= { left, right, top, bottom };
+	int e0= -1, e1= -1;
+	t0= 0.0;
+	t1= 1.0;
+	for (int i= 0; i < 4; ++i) {
+	    if (p[i] == 0.0) {
+		if (q[i] < 0.0) return false;   // parallel and outside
+		continue;
+	    }
+	    const double t= q[i] / p[i];
+	    if (p[i] < 0.0) {
+		if (t > t1) return false;
+		if (t > t0) { t0= t; e0= i; }
+	    } else {
+		if (t < t0) return false;
+		if (t < t1) { t1= t; e1= i; }
+	    }
+	}
+	// the coordinate across the clipping edge is set exactly, as
+	// t * d may have lost all precision for very long segments
+	if (e1 >= 0) {
+	    x1= e1 < 2 ? edge[e1] : x0 + t1 * dx;
+	    y1= e1 < 2 ? y0 + t1 * dy : edge[e1];
+	}
+	if (e0 >= 0) {
+	    const double x= e0 < 2 ? edge[e0] : x0 + t0 * dx;
+	    y0= e0 < 2 ? y0 + t0 * dy : edge[e0];
+	    x0= x;
+	}
+	return true;
+    }
+
+    /*! Visit the pixels of a 1-px aliased line between exact points
+     *
+     *  The segment is clipped to the canvas before it is rounded, so
+     *  end points far outside do neither change the slope of the
+     *  visible part nor make the walk longer than the canvas.
+     *  Segments with an end point which is not finite are skipped.
+     *
+     *  \param plot functor taking two int arguments
+     */
+    template <class F>
+    void raster_segment(double x0, double y0, double x1, double y1,
+			int width, int height, F plot)
+    {
+	double t0, t1;
+	if (!clip_segment(x0, y0, x1, y1, -0.5, -0.5,
+			  width - 0.5, height - 0.5, t0, t1))
+	    return;
+	raster_line(ROUND(x0), ROUND(y0), ROUND(x1), ROUND(y1),
+		    width, height, plot);
+    }
+
+    /*! Visit the pixels of a filled, aliased disc
+     *
+     *  The disc is plotted as one horizontal span per row; rows and
+     *  span ends outside [0,width) x [0,height) are skipped.
+     *
+     *  \param plot functor taking two int arguments
+     */
+    template <class F>
+    void raster_disc(int cx, int cy, int radius,
+		     int width, int height, F plot)
+    {
+	if (cx + radius < 0 || cx - radius >= width ||
+	    cy + radius < 0 || cy - radius >= height)
+	    return;
+
+	const int rr= radius * radius + radius;
+	for (int dy= -radius; dy <= radius; ++dy) {
+	    const int y= cy + dy;
+	    if (y < 0 || y >= height) continue;
+	    int dx= radius;
+	    while (dx * dx + dy * dy > rr) --dx;
+	    const int x1= MAX(cx - dx, 0), x2= MIN(cx + dx, width - 1);
+	    for (int x= x1; x <= x2; ++x)
+		plot(x, y);
+	}
+    }
+
+    /*! Convert a transformed coordinate into a pixel coordinate
+     *
+     *  Coordinates which are not finite or which are far outside any
+     *  canvas are limited so that the line walk stays bounded.
+     *  \return false if v is NaN
+     */
+    inline bool raster_coord(double v, int &p)
+    {
+	if (!(v == v)) return false;
+	p= ROUND(value_limes(v, -65536.0, 65536.0));
+	return true;
+    }
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include <cairomm/context.h>
+
+#include "renderthread.h"
+#include "curve.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+//! Constructor, starts the worker thread
+RenderThread::RenderThread() :
+    lastWidth_(0),
+    lastHeight_(0),
+    valid_(false),
+    hasPending_(false),
+    running_(0),
+    stop_(false),
+    generation_(0)
+{
+    dispatcher_.connect(sigc::mem_fun(*this, &RenderThread::on_done_));
+    thread_= std::thread(&RenderThread::run_, this);
+}
+
+/*! Destructor
+ *
+ *  The worker stops after the curve it is drawing and is joined.
+ */
+RenderThread::~RenderThread()
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	stop_= true;
+	++generation_;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+/*! Request the given curves to be drawn into a surface of the given size
+ *
+ *  Nothing is requested if neither the curves, their serial numbers
+ *  nor their maps have changed since the last request.
+ *
+ *  \param rest receives the items whose curves cannot be cloned
+ *  \return true if a new surface was requested
+ */
+bool RenderThread::request(const std::vector<Item> &items,
+			   int width, int height, std::vector<Item> &rest)
+{
+    bool changed= !valid_ || width != lastWidth_ || height != lastHeight_;
+    std::map<const Curve *, Snapshot> snapshots;
+    Job job;
+
+    // a job still waiting is replaced by this request anyway; once it
+    // is withdrawn, only the copies of the running job are in use
+    unsigned long running= 0;
+    bool renew= false;
+    for (unsigned int i= 0; !renew && i < items.size(); ++i) {
+	std::map<const Curve *, Snapshot>::iterator s=
+	    snapshots_.find(items[i].curve.operator->());
+	renew= s == snapshots_.end() ||
+	    s->second.serial != items[i].curve->serial();
+    }
+    if (renew) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	hasPending_= false;
+	running= running_;
+	changed= true;
+    }
+
+    rest.clear();
+    for (unsigned int i= 0; i < items.size(); ++i) {
+	const Item &it= items[i];
+	const Curve *c= it.curve.operator->();
+	std::map<const Curve *, Snapshot>::iterator s= snapshots_.find(c);
+	Snapshot snap;
+	if (s != snapshots_.end())
+	    snap= s->second;
+	else {
+	    snap.original= it.curve;
+	    snap.serial= c->serial() + 1;
+	    snap.current= 0;
+	    snap.generation[0]= snap.generation[1]= 0;
+	}
+	if (snap.serial != c->serial()) {
+	    // refresh a copy the worker is not drawing
+	    int k= 1 - snap.current;
+	    if (running && snap.generation[k] == running)
+		k= snap.current;
+	    if (!snap.copy[k] ||
+		!c->update_copy(*snap.copy[k].operator->()))
+		snap.copy[k]= it.curve->clone();
+	    snap.current= k;
+	    snap.serial= c->serial();
+	}
+	snapshots[c]= snap;
+
+	const Glib::RefPtr<Curve> &copy= snap.copy[snap.current];
+	if (!copy) {
+	    rest.push_back(it);
+	    continue;
+	}
+	Item item= it;
+	item.curve= copy;
+	job.items.push_back(item);
+    }
+    snapshots_.swap(snapshots);
+
+    if (job.items.size() != last_.size())
+	changed= true;
+    for (unsigned int i= 0; !changed && i < job.items.size(); ++i) {
+	changed= job.items[i].curve != last_[i].curve ||
+	    job.items[i].xMap != last_[i].xMap ||
+	    job.items[i].yMap != last_[i].yMap;
+    }
+    if (!changed) return false;
+
+    last_= job.items;
+    lastWidth_= width;
+    lastHeight_= height;
+    valid_= true;
+
+    job.width= MAX(width, 1);
+    job.height= MAX(height, 1);
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	job.generation= ++generation_;
+	std::map<const Curve *, Snapshot>::iterator s;
+	for (s= snapshots_.begin(); s != snapshots_.end(); ++s)
+	    s->second.generation[s->second.current]= job.generation;
+	std::swap(job, pending_);
+	hasPending_= true;
+    }
+    cond_.notify_one();
+    return true;
+}
+
+/*! Make the next request() draw the curves even if they seem unchanged
+ *
+ *  This is needed after changes which do not advance Curve::serial(),
+ *  e.g. of the curve's paint().
+ */
+void RenderThread::invalidate()
+{
+    valid_= false;
+}
+
+//! Worker loop
+void RenderThread::run_()
+{
+    for (;;) {
+	Job job;
+	{
+	    std::unique_lock<std::mutex> lock(mutex_);
+	    running_= 0;
+	    while (!stop_ && !hasPending_)
+		cond_.wait(lock);
+	    if (stop_) return;
+	    std::swap(job, pending_);
+	    hasPending_= false;
+	    running_= job.generation;
+	}
+
+	Cairo::RefPtr<Cairo::ImageSurface> surface=
+	    Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+					job.width, job.height);
+	bool complete= true;
+	{
+	    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(surface);
+	    for (unsigned int i= 0; i < job.items.size(); ++i) {
+		if (generation_ != job.generation) {
+		    complete= false;
+		    break;
+		}
+		const Item &it= job.items[i];
+		it.curve->draw(cr, Glib::RefPtr<Gdk::Window>(),
+			       it.xMap, it.yMap);
+	    }
+	}
+	if (!complete) continue;
+	surface->flush();
+
+	// the surface replaced here was never seen by the main thread
+	{
+	    std::lock_guard<std::mutex> lock(mutex_);
+	    done_.swap(surface);
+	}
+	dispatcher_.emit();
+    }
+}
+
+//! Take over the surface completed by the worker
+void RenderThread::on_done_()
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!done_) return;
+	front_.swap(done_);
+	done_= Cairo::RefPtr<Cairo::ImageSurface>();
+    }
+    signal_ready();
+}
@@ -0,0 +1,119 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_RENDERTHREAD_H
+#define PLOTMM_RENDERTHREAD_H
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glibmm/refptr.h>
+#include <glibmm/dispatcher.h>
+#include <cairomm/surface.h>
+
+#include "doubleintmap.h"
+
+namespace PlotMM {
+
+    class Curve;
+
+    /*! @brief Draws curves into an image surface on a worker thread
+     *
+     *  request() takes copies (Curve::clone()) of the curves and of
+     *  their maps and hands them to the worker, so that neither the
+     *  data nor the scales may change while the worker draws.  Copies
+     *  are kept between requests and only renewed if Curve::serial()
+     *  of the original has changed.  Two copies are kept per curve,
+     *  so that the one the worker is not drawing can be brought up to
+     *  date with Curve::update_copy(); for a curve which is only
+     *  appended to, the main thread then copies just the new samples.
+     *
+     *  The worker draws into a new surface for every request.  A
+     *  request made while another one is waiting replaces it, and a
+     *  request made while the worker is busy makes it stop after the
+     *  curve it is currently drawing.  When a surface is complete,
+     *  signal_ready is emitted in the main loop and surface() returns
+     *  it until the next one is complete.
+     *
+     *  Curves whose clone() is empty are not drawn; request() returns
+     *  them so that the caller can draw them itself.
+     */
+    class RenderThread
+    {
+    public:
+	//! A curve together with the maps it is drawn with
+	struct Item
+	{
+	    Glib::RefPtr<Curve> curve;
+	    DoubleIntMap xMap, yMap;
+	};
+
+	RenderThread();
+	~RenderThread();
+
+	bool request(const std::vector<Item> &items, int width, int height,
+		     std::vector<Item> &rest);
+	void invalidate();
+
+	//! Return the latest complete surface (may be empty)
+	Cairo::RefPtr<Cairo::ImageSurface> surface() const { return front_; }
+
+	//! Emitted in the main loop when a new surface() is available
+	sigc::signal0<void> signal_ready;
+
+    private:
+	RenderThread(const RenderThread &);
+	RenderThread &operator=(const RenderThread &);
+
+	struct Job
+	{
+	    std::vector<Item> items;
+	    int width, height;
+	    unsigned long generation;
+	};
+
+	struct Snapshot
+	{
+	    Glib::RefPtr<Curve> original;   // keeps the key valid
+	    unsigned long serial;
+	    int current;                    // copy used by the latest job
+	    Glib::RefPtr<Curve> copy[2];
+	    unsigned long generation[2];    // latest job using copy[i]
+	};
+
+	void run_();
+	void on_done_();
+
+	// main thread only
+	std::map<const Curve *, Snapshot> snapshots_;
+	std::vector<Item> last_;
+	int lastWidth_, lastHeight_;
+	bool valid_;
+	Cairo::RefPtr<Cairo::ImageSurface> front_;
+
+	// shared with the worker
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	Job pending_;
+	bool hasPending_;
+	unsigned long running_;             // job being drawn, 0 if none
+	bool stop_;
+	std::atomic<unsigned long> generation_;
+	Cairo::RefPtr<Cairo::ImageSurface> done_;
+	Glib::Dispatcher dispatcher_;
+
+	std::thread thread_;
+    };
+
+}
+
+#endif
@@ -6,7 +6,10 @@
  * modify it under the terms of the LGPL
  *****************************************************************************/
 
+#include <charconv>
+
 #include <pangomm/layout.h>
+#include <glibmm/main.h>
 
 #include "scale.h"
 
@@ -21,6 +24,10 @@ using namespace PlotMM;
 /*! Constructor
  */
 ScaleLabels::ScaleLabels(Gtk::PositionType p) :
+    offset_(0),
+    extent_(0),
+    shrinkTo_(0),
+    shrinkDelay_(2000),
     position_(p),  // p is POS_LEFT, POS_RIGHT, ... etc. gtk constants.
     enabled_(true)
 {
@@ -32,6 +39,64 @@ ScaleLabels::ScaleLabels(Gtk::PositionType p) :
 /*! Destructor */
 ScaleLabels::~ScaleLabels()
 {
+    shrink_.disconnect();
+}
+
+/*! Set how long the labels must need less room before it is released
+ *
+ *  The width of vertical and the height of horizontal labels grows
+ *  as soon as a label needs more room, but shrinks only after the
+ *  smaller size has been sufficient for ms milliseconds.  Changing
+ *  ticks thus do not make Gtk lay out the plot again and again.
+ */
+void ScaleLabels::set_shrink_delay(unsigned int ms)
+{
+    shrinkDelay_= ms;
+}
+
+/*! Request room for the labels across the scale
+ *
+ *  \param n width of vertical or height of horizontal labels
+ *  \sa set_shrink_delay
+ */
+void ScaleLabels::request_extent_(int n)
+{
+    if (n >= extent_) {
+	shrink_.disconnect();
+	if (n == extent_) return;
+	extent_= n;
+    } else {
+	if (shrink_.connected()) {
+	    shrinkTo_= MAX(shrinkTo_, n);
+	    return;
+	}
+	shrinkTo_= n;
+	if (shrinkDelay_ > 0) {
+	    shrink_= Glib::signal_timeout().connect(
+		sigc::mem_fun(*this, &ScaleLabels::on_shrink_timeout_),
+		shrinkDelay_);
+	    return;
+	}
+	extent_= n;
+    }
+    apply_extent_();
+}
+
+//! Releases the room not needed during the shrink delay
+bool ScaleLabels::on_shrink_timeout_()
+{
+    extent_= shrinkTo_;
+    apply_extent_();
+    return false;
+}
+
+//! Request the current extent from Gtk
+void ScaleLabels::apply_extent_()
+{
+    if (position_==Gtk::POS_LEFT || position_==Gtk::POS_RIGHT)
+	set_size_request(extent_,-1);
+    else
+	set_size_request(-1,extent_);
 }
 
 /*! Set the labels to be drawn
@@ -40,15 +105,26 @@ ScaleLabels::~ScaleLabels()
  *  a scale.  The given offs can be taken as a hint to calculate the
  *  right positions for the labels.  Normally, the leftmost or upmost
  *  border of the scale's Gdk::Window is taken for this offset.
+ *  Nothing happens if neither the offset nor the labels have changed.
  *
  *  \sa newsize_ (called automatically)
  */
-void ScaleLabels::set_labels(int offs, const std::map<int,double> &labels)
+void ScaleLabels::set_labels(int offs, const Positions &labels)
 {
+    if (offs == offset_ && labels == labels_) return;
     offset_= offs;
     labels_= labels;
+    prune_labels_();
     newsize_();
     update_();
+    queue_draw();
+}
+
+/*! \overload
+ */
+void ScaleLabels::set_labels(int offs, const std::map<int,double> &labels)
+{
+    set_labels(offs, Positions(labels.begin(), labels.end()));
 }
 
 /*! Enable drawing of scalelabels
@@ -69,8 +145,72 @@ void ScaleLabels::set_enabled(bool b)
 Glib::ustring ScaleLabels::format(double d) const
 {
     char tmp[100];
-    sprintf(tmp,"%g",d);  // prints a double to a string tmp
-    return tmp;
+    // same result as "%g", without parsing a format string
+    std::to_chars_result r= std::to_chars(tmp, tmp+sizeof(tmp), d,
+					     std::chars_format::general, 6);
+    return std::string(tmp, r.ptr);
+}
+
+/*! Return the formatted label for a value
+ *
+ *  Labels are cached together with their pixel size, so a label is
+ *  only formatted once as long as it is shown.  Numeric labels are
+ *  composed from the glyph atlas of the font; anything else is shaped
+ *  by Pango.  The cache and the atlas are cleared when font() has
+ *  changed.
+ */
+const ScaleLabels::Label &ScaleLabels::label_(double d)
+{
+    if (cacheFont_ != font_) {
+	cache_.clear();
+	atlas_.clear();
+	cacheFont_= font_;
+    }
+    std::map<double,Label>::iterator l= cache_.find(d);
+    if (l != cache_.end()) return l->second;
+
+    if (!atlas_.valid()) {
+	layout_->set_font_description(font_);
+	atlas_.build(layout_);
+    }
+
+    Label &lbl= cache_[d];
+    lbl.text= format(d);
+    if (atlas_.supports(lbl.text)) {
+	lbl.mask= atlas_.compose(lbl.text, lbl.maskX, lbl.maskY);
+	lbl.width= atlas_.text_width(lbl.text);
+	lbl.height= atlas_.height();
+    } else {
+	lbl.layout= create_pango_layout(lbl.text);
+	lbl.layout->set_font_description(font_);
+	lbl.layout->get_pixel_size(lbl.width,lbl.height);
+    }
+    return lbl;
+}
+
+//! Draw a label with its top left corner at x, y
+void ScaleLabels::draw_label_(const Cairo::RefPtr<Cairo::Context> &cr,
+			      const Label &lbl, int x, int y)
+{
+    if (lbl.mask) {
+	cr->mask(lbl.mask, x + lbl.maskX, y + lbl.maskY);
+    } else {
+	cr->move_to(x, y);
+	lbl.layout->show_in_cairo_context(cr);
+    }
+}
+
+//! Drop cached labels of values which are no longer shown
+void ScaleLabels::prune_labels_()
+{
+    std::map<double,Label> keep;
+    Positions::const_iterator daPos;
+    for (daPos= labels_.begin(); daPos!=labels_.end(); ++daPos) {
+	std::map<double,Label>::iterator l= cache_.find(daPos->second);
+	if (l != cache_.end())
+	    keep[l->first]= l->second;
+    }
+    cache_.swap(keep);
 }
 
 /*! Query the pixel width of the given text when rendered with the
@@ -165,6 +305,8 @@ void ScaleLabels::newsize_()
 {
     if (!labels_.size()) return;  // if there are no labels, return
     if (!enabled()) {
+	shrink_.disconnect();
+	extent_= 0;
 	set_size_request(0,0);  // make as small as possible if not drawn
 	return;
     } else {
@@ -173,9 +315,9 @@ void ScaleLabels::newsize_()
 	int min, max;
 	min= max= labels_.begin()->first;
 
-	std::map<int,double>::iterator daPos;
+	Positions::const_iterator daPos;
 	for (daPos= labels_.begin(); daPos!=labels_.end(); ++daPos) {
-	    layw_= MAX(layw_,text_width(format(daPos->second)));
+	    layw_= MAX(layw_,label_(daPos->second).width);
 	    min= MIN(min,daPos->first);
 	    max= MAX(max,daPos->first);
 	}
@@ -191,7 +333,7 @@ void VScaleLabels::requestsize_()
 
 //    int winx,winy,winw,winh,wind;
 //    window->get_geometry(winx, winy, winw, winh);
-    set_size_request(layw_,-1);
+    request_extent_(layw_);
 }
 
 void HScaleLabels::requestsize_()
@@ -201,7 +343,7 @@ void HScaleLabels::requestsize_()
 
 //    int winx,winy,winw,winh,wind;
 //    window->get_geometry(winx, winy, winw, winh);
-    set_size_request(-1,layh_);
+    request_extent_(layh_);
 }
 
 /* ****************************************************************** */
@@ -224,12 +366,11 @@ void VScaleLabels::update_(const Cairo::RefPtr<Cairo::Context> &cr)
     cr->set_source_rgb(0.0, 0.0, 0.0);
 
 
-    std::map<int,double>::iterator daPos;
-    layout_->set_font_description(font_);
+    Positions::const_iterator daPos;
     for (daPos= labels_.begin(); daPos!=labels_.end(); ++daPos) {
-	layout_->set_text(format(daPos->second));
-	layout_->context_changed();
-	layout_->get_pixel_size(layw,layh);
+	const Label &lbl= label_(daPos->second);
+	layw= lbl.width;
+	layh= lbl.height;
 	int lx=0,ly=offset_-winy-layh/2+daPos->first;
 	if (position()==Gtk::POS_LEFT) {
 	    lx= winw-layw;
@@ -237,9 +378,7 @@ void VScaleLabels::update_(const Cairo::RefPtr<Cairo::Context> &cr)
 	if (ly<0) ly=0;
 	else if (ly+layh>winh) ly=winh-layh;
 
-    cr->move_to(lx, ly);
-
-    layout_->show_in_cairo_context (cr);
+    draw_label_(cr, lbl, lx, ly);
 
     cr->stroke();
     }
@@ -263,13 +402,12 @@ void HScaleLabels::update_(const Cairo::RefPtr<Cairo::Context> &cr)
     window->get_geometry(winx, winy, winw, winh);
     //window->clear();
 
-    std::map<int,double>::iterator daPos;
-    layout_->set_font_description(font_);
+    Positions::const_iterator daPos;
     for (daPos= labels_.begin(); daPos!=labels_.end(); ++daPos)
      {
-        layout_->set_text(format(daPos->second));
-        layout_->context_changed();
-        layout_->get_pixel_size(layw,layh);
+        const Label &lbl= label_(daPos->second);
+        layw= lbl.width;
+        layh= lbl.height;
         int lx=offset_-winx-layw/2+daPos->first, ly=0;
         if (position()==Gtk::POS_TOP)
             ly= winh-layh;
@@ -278,9 +416,7 @@ void HScaleLabels::update_(const Cairo::RefPtr<Cairo::Context> &cr)
         else if (lx+layw>winw)
             lx=winw-layw;
 
-        cr->move_to(lx, ly);
-
-        layout_->show_in_cairo_context(cr);
+        draw_label_(cr, lbl, lx, ly);
     }
         cr->stroke();
 
@@ -302,7 +438,16 @@ Scale::Scale(Gtk::PositionType p, ScaleLabels *l) :
     position_(p),
     enabled_(false),
     majorTL_(10),
-    minorTL_(5)
+    minorTL_(5),
+    headroom_(0.0),
+    expandOnly_(false),
+    snap_(false),
+    asShrinkDelay_(0),
+    shrinkSince_(0),
+    frozen_(0),
+    divPending_(false),
+    divL_(0),
+    divR_(0)
 {
     set_app_paintable();
     set_range(-1,1,false);
@@ -324,6 +469,7 @@ bool Scale::on_draw(const Cairo::RefPtr<Cairo::Context> &cr)
 void Scale::set_position(Gtk::PositionType p)
 {
     position_= p;
+    invalidate_cache_();
 }
 
 /*! Enable drawing of scales
@@ -340,6 +486,7 @@ void Scale::set_enabled(bool b)
     if (labels_) labels_->set_enabled(b);
     if (b==enabled_) return;
     enabled_= b;
+    invalidate_cache_();
     on_tick_change();
     signal_enabled(enabled_);
 }
@@ -349,6 +496,7 @@ void Scale::set_ticklengths(int major, int minor)
 {
     majorTL_= major;
     minorTL_= minor;
+    invalidate_cache_();
     on_tick_change();
 }
 
@@ -382,16 +530,21 @@ void Scale::set_range(double l, double r)
  *
  *  To make the scale logarithmic, true can be given as the third
  *  argument.  After setting the new range, the scale is redrawn.
+ *  Nothing happens if the range has not changed.
  */
 void Scale::set_range(double l, double r, bool lg)
 {
+    if (l == divL_ && r == divR_ && lg == scaleMap_.logarithmic()) return;
 
-    scaleMap_.set_dbl_range(l,r,false);
+    scaleMap_.set_dbl_range(l,r,lg);
+    divL_= l;
+    divR_= r;
 
-    if (scaleMap_.logarithmic())
-	scaleDiv_.rebuild(l, r, 10, 10, true, 0.0);
-    else
-	scaleDiv_.rebuild(l, r, 10, 10, false, 0.0);
+    if (frozen_) {
+	divPending_= true;
+	return;
+    }
+    rebuild_div_();
 //    if (window_)
 //    {
 //        window_->hide(); window_->show();
@@ -399,6 +552,79 @@ void Scale::set_range(double l, double r, bool lg)
 
 }
 
+/*! Rebuild the scale division for the range last set */
+void Scale::rebuild_div_()
+{
+    divCache_.rebuild(scaleDiv_, divL_, divR_, 10, 10,
+		      scaleMap_.logarithmic(), 0.0);
+}
+
+/*! Defer rebuilding the scale division
+ *
+ *  While the scale is frozen, set_range() only changes the scale_map().
+ *  The division is rebuilt once by the thaw() matching the first
+ *  freeze().  Calls may be nested.
+ */
+void Scale::freeze()
+{
+    ++frozen_;
+}
+
+/*! End a freeze()
+ *
+ *  If the range has been changed meanwhile, the division is rebuilt
+ *  and the scale is redrawn.
+ */
+void Scale::thaw()
+{
+    if (!frozen_ || --frozen_) return;
+    if (!divPending_) return;
+    divPending_= false;
+    rebuild_div_();
+    queue_draw();
+}
+
+/*! Prepare the retained surface for drawing a w x h scale
+ *
+ *  \return a context on the cleared surface, or an empty pointer if
+ *  the surface still shows the current scale_map() and division
+ */
+Cairo::RefPtr<Cairo::Context> Scale::cache_context_(int w, int h)
+{
+    if (surface_ && surface_->get_width() == w &&
+	surface_->get_height() == h &&
+	cacheDiv_ == scaleDiv_ && cacheMap_ == scaleMap_)
+	return Cairo::RefPtr<Cairo::Context>();
+
+    cacheDiv_= scaleDiv_;
+    cacheMap_= scaleMap_;
+    if (!surface_ || surface_->get_width() != w || surface_->get_height() != h)
+	surface_= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+					      MAX(w, 1), MAX(h, 1));
+    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(surface_);
+    cr->save();
+    cr->set_operator(Cairo::OPERATOR_CLEAR);
+    cr->paint();
+    cr->restore();
+    return cr;
+}
+
+//! Paint the retained surface
+void Scale::paint_cache_(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    if (!surface_) return;
+    surface_->flush();
+    cr->set_source(surface_, 0, 0);
+    cr->paint();
+}
+
+//! Redraw the ticks when the scale is exposed next
+void Scale::invalidate_cache_()
+{
+    surface_= Cairo::RefPtr<Cairo::ImageSurface>();
+    queue_draw();
+}
+
 /*! Turn on autoscaling
  */
 void Scale::set_autoscale(bool b)
@@ -438,16 +664,110 @@ void Scale::autoscale(double min, double max)
 /*! Finish update of autoscale information
  *
  *  After updating autoscale information with autoscale(min,max)
- *  this function sets the new range of values.
+ *  this function sets the new range of values.  The range follows the
+ *  autoscale policies: it is changed at once if the data leaves it,
+ *  but a range which is only larger than needed is kept if the scale
+ *  autoscale_expand_only() or while it has been so for less than
+ *  autoscale_shrink_delay().  With a headroom, the data may thus move
+ *  within the padded range without changing the scale.
  *
- *  \sa set_range
+ *  \sa set_range, set_autoscale_headroom, set_autoscale_snap
  */
 void Scale::end_autoscale()
 {
     if (!autoscale_) return;
-    if (asMin_ != asMax_) {
+    if (asMin_ == asMax_) return;
+    if (asMin_ > asMax_) {
 	set_range(asMin_,asMax_,scaleMap_.logarithmic());
+	return;
     }
+
+    const double cl= MIN(divL_,divR_), ch= MAX(divL_,divR_);
+    double lo= asMin_, hi= asMax_;
+    autoscale_target_(lo,hi);
+    if (lo == cl && hi == ch) {
+	shrinkSince_= 0;
+	return;
+    }
+
+    if (asMin_ >= cl && asMax_ <= ch) {
+	// the data is still inside, the range is only larger than needed
+	if (expandOnly_) return;
+	if ((ch-cl) <= (hi-lo)*(1.0+2.0*headroom_)) {
+	    shrinkSince_= 0;
+	    return;
+	}
+	if (asShrinkDelay_) {
+	    const gint64 now= g_get_monotonic_time();
+	    if (!shrinkSince_) shrinkSince_= now;
+	    if (now - shrinkSince_ < gint64(asShrinkDelay_)*1000) return;
+	}
+    }
+    shrinkSince_= 0;
+    set_range(lo,hi,scaleMap_.logarithmic());
+}
+
+/*! Pad and snap an autoscaled range
+ *
+ *  Logarithmic scales are padded and snapped in decades.
+ */
+void Scale::autoscale_target_(double &lo, double &hi) const
+{
+    const bool lg= scaleMap_.logarithmic() && lo > 0.0;
+    if (lg) {
+	lo= log10(lo);
+	hi= log10(hi);
+    }
+    const double pad= (hi-lo)*headroom_;
+    lo-= pad;
+    hi+= pad;
+    if (snap_) {
+	const double step= lg ? 1.0 : ceil_125((hi-lo)*0.999999/10.0);
+	if (step > 0.0) {
+	    lo= floor(lo/step)*step;
+	    hi= ceil(hi/step)*step;
+	}
+    }
+    if (lg) {
+	lo= pow(10.0,lo);
+	hi= pow(10.0,hi);
+    }
+}
+
+/*! Set the headroom of autoscaled ranges
+ *
+ *  The range is extended by h times the data extent on both sides.
+ *  Data moving within the headroom does not change the scale.
+ */
+void Scale::set_autoscale_headroom(double h)
+{
+    headroom_= MAX(0.0,h);
+}
+
+/*! Let autoscaling only extend the range, never shrink it
+ */
+void Scale::set_autoscale_expand_only(bool b)
+{
+    expandOnly_= b;
+}
+
+/*! Let autoscaled ranges start and end at major ticks
+ */
+void Scale::set_autoscale_snap(bool b)
+{
+    snap_= b;
+}
+
+/*! Set how long a smaller autoscaled range must suffice before the
+ *  range shrinks
+ *
+ *  The delay is checked in end_autoscale(), so the range shrinks with
+ *  the first update after it has passed.
+ */
+void Scale::set_autoscale_shrink_delay(unsigned int ms)
+{
+    asShrinkDelay_= ms;
+    shrinkSince_= 0;
 }
 
 /*! Handles an expose event */
@@ -485,7 +805,12 @@ void VScale::on_tick_change()
 	set_size_request(1,-1);
 }
 
-/*! Draws the scale  (line and tickmarks) */
+/*! Draws the scale  (line and tickmarks)
+ *
+ *  The ticks are drawn into the retained surface of the scale only
+ *  if the division, the map or the size have changed; otherwise the
+ *  surface is painted as it is.
+ */
 void VScale::redraw(const Cairo::RefPtr<Cairo::Context> &VS_cr)
 {
 
@@ -494,50 +819,42 @@ void VScale::redraw(const Cairo::RefPtr<Cairo::Context> &VS_cr)
     int winx, winy, winw, winh;
     get_window()->get_geometry(winx, winy, winw, winh);
 
-
-//    VS_cr = window_->create_cairo_context();
-
-
-	VS_cr->set_line_width(1.0);
-    VS_cr->set_source_rgb(0.0,0.0,0.0);
-
     scaleMap_.set_int_range(winh-1,0);
-    int i, iy;
-    double y;
-    int l0= 0;
-    int l1= minor_ticklength();
-    int l2= major_ticklength();
-    if (position()==Gtk::POS_LEFT) {
-	l0= winw;
-	l1= l0-l1;
-	l2= l0-l2;
-    }
-    std::map<int,double> lblpos;
-    for (i=0;i<(int)scaleDiv_.maj_count();i++) {
-	y= scaleDiv_.maj_mark(i);
-	iy= scaleMap_.transform(y);
-	if (labels_) lblpos[iy]= y;
-	//window_->draw_line(gc_,l0,iy,l2,iy);
-	VS_cr->move_to(l0, iy);
-	VS_cr->line_to(l2, iy);
-	VS_cr->stroke();
-    }
-    for (i=0;i<(int)scaleDiv_.min_count();i++) {
-	y= scaleDiv_.min_mark(i);
-	iy= scaleMap_.transform(y);
-	//window_->draw_line(gc_,l0,iy,l1,iy);
-	VS_cr->move_to(l0, iy);
-	VS_cr->line_to(l1, iy);
-	VS_cr->stroke();
+    Cairo::RefPtr<Cairo::Context> cr= cache_context_(winw, winh);
+    if (cr) {
+	cr->set_line_width(1.0);
+	cr->set_source_rgb(0.0,0.0,0.0);
+
+	int i, iy;
+	double y;
+	int l0= 0;
+	int l1= minor_ticklength();
+	int l2= major_ticklength();
+	if (position()==Gtk::POS_LEFT) {
+	    l0= winw;
+	    l1= l0-l1;
+	    l2= l0-l2;
+	}
+	lblpos_.clear();
+	for (i=0;i<(int)scaleDiv_.maj_count();i++) {
+	    y= scaleDiv_.maj_mark(i);
+	    iy= scaleMap_.transform(y);
+	    if (labels_) lblpos_.push_back(std::make_pair(iy, y));
+	    cr->move_to(l0, iy);
+	    cr->line_to(l2, iy);
+	}
+	for (i=0;i<(int)scaleDiv_.min_count();i++) {
+	    iy= scaleMap_.transform(scaleDiv_.min_mark(i));
+	    cr->move_to(l0, iy);
+	    cr->line_to(l1, iy);
+	}
+	cr->move_to(l0, 0);
+	cr->line_to(l0, winh-1);
+	cr->stroke();
     }
-    //window_->draw_line(gc_,l0,0,l0,winh-1);
-    VS_cr->move_to(l0, 0);
-	VS_cr->line_to(l0, winh-1);
-	VS_cr->stroke();
-
-    if (labels_) labels_->set_labels(winy,lblpos);
+    paint_cache_(VS_cr);
 
-//    show_all();
+    if (labels_) labels_->set_labels(winy,lblpos_);
 }
 
 /*! Constructor
@@ -568,7 +885,10 @@ void HScale::on_tick_change()
 	set_size_request(-1,1);
 }
 
-/*! Draws the scale */
+/*! Draws the scale
+ *
+ *  \sa VScale::redraw
+ */
 void HScale::redraw(const Cairo::RefPtr<Cairo::Context> &HS_cr)
 {
 
@@ -576,45 +896,41 @@ void HScale::redraw(const Cairo::RefPtr<Cairo::Context> &HS_cr)
     int winx, winy, winw, winh;
     window_->get_geometry(winx, winy, winw, winh);
 
-//    HS_cr = window_->create_cairo_context();
-
-    HS_cr->set_line_width(1.0);
-    HS_cr->set_source_rgb(0.0,0.0,0.0);
-    //window_->clear();
     scaleMap_.set_int_range(0,winw-1);
-    int i, ix;
-    double x;
-    int l0= 0;
-    int l1= minor_ticklength();
-    int l2= major_ticklength();
-    if (position()==Gtk::POS_TOP) {
-	l0= winh;
-	l1= l0-l1;
-	l2= l0-l2;
+    Cairo::RefPtr<Cairo::Context> cr= cache_context_(winw, winh);
+    if (cr) {
+	cr->set_line_width(1.0);
+	cr->set_source_rgb(0.0,0.0,0.0);
+
+	int i, ix;
+	double x;
+	int l0= 0;
+	int l1= minor_ticklength();
+	int l2= major_ticklength();
+	if (position()==Gtk::POS_TOP) {
+	    l0= winh;
+	    l1= l0-l1;
+	    l2= l0-l2;
+	}
+	lblpos_.clear();
+	for (i=0;i<(int)scaleDiv_.maj_count();i++) {
+	    x= scaleDiv_.maj_mark(i);
+	    ix= scaleMap_.transform(x);
+	    if (labels_) lblpos_.push_back(std::make_pair(ix, x));
+	    cr->move_to(ix, l0);
+	    cr->line_to(ix, l2);
+	}
+	for (i=0;i<(int)scaleDiv_.min_count();i++) {
+	    ix= scaleMap_.transform(scaleDiv_.min_mark(i));
+	    cr->move_to(ix, l0);
+	    cr->line_to(ix, l1);
+	}
+	cr->move_to(0, l0);
+	cr->line_to(winw-1, l0);
+	cr->stroke();
     }
+    paint_cache_(HS_cr);
 
-    std::map<int,double> lblpos;
-    for (i=0;i<(int)scaleDiv_.maj_count();i++) {
-	x= scaleDiv_.maj_mark(i);
-	ix= scaleMap_.transform(x);
-	if (labels_) lblpos[ix]= x;
-	//window_->draw_line(gc_,ix,l0,ix,l2);
-	HS_cr->move_to(ix, l0);
-	HS_cr->line_to(ix, l2);
-	HS_cr->stroke();
-    }
-    for (i=0;i<(int)scaleDiv_.min_count();i++) {
-	x= scaleDiv_.min_mark(i);
-	ix= scaleMap_.transform(x);
-	//window_->draw_line(gc_,ix,l0,ix,l1);
-	HS_cr->move_to(ix, l0);
-	HS_cr->line_to(ix, l1);
-	HS_cr->stroke();
-    }
-    //window_->draw_line(gc_,0,l0,winw-1,l0);
-    HS_cr->move_to(0, l0);
-	HS_cr->line_to(winw-1, l0);
-	HS_cr->stroke();
-    if (labels_) labels_->set_labels(winx,lblpos);
+    if (labels_) labels_->set_labels(winx,lblpos_);
 }
 
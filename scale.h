@@ -18,6 +18,7 @@
 
 #include "doubleintmap.h"
 #include "scalediv.h"
+#include "glyphatlas.h"
 
 namespace Pango {
     class Layout;
@@ -31,12 +32,16 @@ namespace PlotMM
      */
 class ScaleLabels : public Gtk::DrawingArea {
     public:
+	//! Pixel positions of labels along the scale with their values
+	typedef std::vector<std::pair<int,double> > Positions;
+
 	ScaleLabels(Gtk::PositionType p);
 	virtual ~ScaleLabels();
 
 	//! Return a pointer to the labels' font
 	Pango::FontDescription *font() { return &font_; }
     void set_font(Pango::FontDescription fd) { font_ = fd;}
+	void set_labels(int offs, const Positions &labels);
 	void set_labels(int offs, const std::map<int,double> &labels);
 
 	void set_enabled(bool b);
@@ -48,20 +53,52 @@ class ScaleLabels : public Gtk::DrawingArea {
 	//! Return where the labels are positioned
 	Gtk::PositionType position() const { return position_; }
 
+	void set_shrink_delay(unsigned int ms);
+	//! Return how long a smaller size must be stable to be applied (ms)
+	unsigned int shrink_delay() const { return shrinkDelay_; }
+
     protected:
+	/*! A formatted label with its pixel size and either an alpha
+	 *  mask composed from the GlyphAtlas, placed at maskX, maskY
+	 *  relative to the label, or a shaped layout
+	 *  \sa label_, draw_label_
+	 */
+	struct Label
+	{
+	    Glib::ustring text;
+	    Cairo::RefPtr<Cairo::ImageSurface> mask;
+	    int maskX, maskY;
+	    Glib::RefPtr<Pango::Layout> layout;
+	    int width, height;
+	};
+
 	virtual void update_() {}
 	virtual void newsize_();
 	virtual void requestsize_() {}
 
+	const Label &label_(double d);
+	void prune_labels_();
+	void draw_label_(const Cairo::RefPtr<Cairo::Context> &cr,
+			 const Label &lbl, int x, int y);
+	void request_extent_(int n);
+	bool on_shrink_timeout_();
+	void apply_extent_();
+
     Glib::RefPtr<Gdk::Window> window_;
 	int offset_;
 	int layw_, layh_;
 	int range_;
-	std::map<int,double> labels_;
+	Positions labels_;
 	Glib::RefPtr<Pango::Layout> layout_;
 	Pango::FontDescription font_;
 
     private:
+	std::map<double,Label> cache_;
+	Pango::FontDescription cacheFont_;
+	GlyphAtlas atlas_;
+	int extent_, shrinkTo_;
+	unsigned int shrinkDelay_;
+	sigc::connection shrink_;
 	Gtk::PositionType position_;
 	bool enabled_;
     };
@@ -130,6 +167,9 @@ class HScaleLabels : public ScaleLabels {
 	void set_range(double l, double r);
 	void set_range(double l, double r, bool lg);
 
+	void freeze();
+	void thaw();
+
 	void set_autoscale(bool b);
 	//! Query if autoscaling is enabled
 	bool autoscale() const { return autoscale_; }
@@ -137,6 +177,19 @@ class HScaleLabels : public ScaleLabels {
 	void autoscale(double min, double max);
 	void end_autoscale();
 
+	void set_autoscale_headroom(double h);
+	//! Return the fraction of the data extent added on both sides
+	double autoscale_headroom() const { return headroom_; }
+	void set_autoscale_expand_only(bool b);
+	//! Query if autoscaling never shrinks the range
+	bool autoscale_expand_only() const { return expandOnly_; }
+	void set_autoscale_snap(bool b);
+	//! Query if autoscaled ranges end at major ticks
+	bool autoscale_snap() const { return snap_; }
+	void set_autoscale_shrink_delay(unsigned int ms);
+	//! Return how long a smaller range must suffice before it is applied
+	unsigned int autoscale_shrink_delay() const { return asShrinkDelay_; }
+
 	/*! This signal is thrown whenever the scale is enabled or disabled
 	 *  \sa set_enabled, enabled
 	 */
@@ -154,12 +207,17 @@ class HScaleLabels : public ScaleLabels {
 	// virtual methods can be called from the base class.
 	virtual void on_tick_change() {}
 
+	Cairo::RefPtr<Cairo::Context> cache_context_(int w, int h);
+	void paint_cache_(const Cairo::RefPtr<Cairo::Context> &cr);
+	void invalidate_cache_();
+
 	Glib::RefPtr<Gdk::Window> window_;
 	Glib::RefPtr<Gdk::Window> labwin_;
 	ScaleLabels *labels_;
 
 	ScaleDiv scaleDiv_;
 	DoubleIntMap scaleMap_;
+	ScaleLabels::Positions lblpos_;
 
     private:
 	Gtk::PositionType position_;
@@ -167,6 +225,21 @@ class HScaleLabels : public ScaleLabels {
 	bool enabled_;
 	int majorTL_, minorTL_;
 	double asMin_, asMax_;
+	double headroom_;
+	bool expandOnly_, snap_;
+	unsigned int asShrinkDelay_;
+	gint64 shrinkSince_;
+	int frozen_;
+	bool divPending_;
+	double divL_, divR_;
+	ScaleDivCache divCache_;
+
+	Cairo::RefPtr<Cairo::ImageSurface> surface_;
+	ScaleDiv cacheDiv_;
+	DoubleIntMap cacheMap_;
+
+	void rebuild_div_();
+	void autoscale_target_(double &lo, double &hi) const;
     };
 
     /*! @brief Class to draw a vertical scale.
@@ -47,6 +47,8 @@ ScaleDiv::ScaleDiv()
     d_hBound = 0.0;
     d_majStep = 0.0;
     d_log = false;
+    d_autoStep = false;
+    d_maxMaj = d_maxMin = 0;
 }
 
 /*!
@@ -84,12 +86,29 @@ ScaleDiv::ScaleDiv()
         from x1 to x2. Defaults to true.
   \return True if the arrays have been allocated successfully.
   \warning For logarithmic scales, the step width is measured in decades.
+
+  If a linear division with an automatic step width is only
+  translated, i.e. its width and the step limits remain the same, the
+  previous step width is kept and only the marks are filled in again.
+  The mark arrays keep their storage if the number of marks does not
+  grow.
 */
 bool ScaleDiv::rebuild(double x1, double x2,
     int maxMajSteps, int maxMinSteps, bool log, double step, bool ascend)
 {
   int rv;
 
+  const bool autoStep = (step == 0.0);
+  const double width = ABS(x2 - x1);
+  if (autoStep && !log && !d_log && d_autoStep && d_majStep > 0.0
+      && maxMajSteps == d_maxMaj && maxMinSteps == d_maxMin
+      && ABS(width - ABS(d_hBound - d_lBound))
+         <= 1.0e-9 * ABS(d_hBound - d_lBound))
+      step = d_majStep;
+  d_autoStep = autoStep;
+  d_maxMaj = maxMajSteps;
+  d_maxMin = maxMinSteps;
+
   d_lBound = MIN(x1, x2);
   d_hBound = MAX(x1, x2);
   d_log = log;
@@ -442,4 +461,61 @@ void ScaleDiv::reset()
     d_hBound = 0.0;
     d_majStep = 0.0;
     d_log = false;
+    d_autoStep = false;
+    d_maxMaj = d_maxMin = 0;
+}
+
+/*!
+  \brief Construct a cache holding up to size divisions
+*/
+ScaleDivCache::ScaleDivCache(unsigned int size) :
+    size_(MAX(1u, size))
+{
+}
+
+/*!
+  \brief Build div like ScaleDiv::rebuild() with ascending marks
+
+  The division is taken from the cache if it has been built with the
+  same parameters before; otherwise it is built and stored.  The least
+  recently used division is dropped when the cache is full.
+*/
+void ScaleDivCache::rebuild(ScaleDiv &div, double x1, double x2,
+			    int maxMajSteps, int maxMinSteps, bool log,
+			    double step)
+{
+    const double lo = MIN(x1, x2), hi = MAX(x1, x2);
+    std::list<Entry>::iterator e;
+    for (e = entries_.begin(); e != entries_.end(); ++e)
+    {
+	if (e->lo == lo && e->hi == hi && e->maxMaj == maxMajSteps
+	    && e->maxMin == maxMinSteps && e->log == log && e->step == step)
+	{
+	    entries_.splice(entries_.begin(), entries_, e);
+	    div = e->div;
+	    return;
+	}
+    }
+
+    div.rebuild(lo, hi, maxMajSteps, maxMinSteps, log, step);
+
+    // reuse the node and the mark storage of the oldest entry
+    if (entries_.size() >= size_)
+	entries_.splice(entries_.begin(), entries_, --entries_.end());
+    else
+	entries_.push_front(Entry());
+    Entry &n = entries_.front();
+    n.lo = lo;
+    n.hi = hi;
+    n.maxMaj = maxMajSteps;
+    n.maxMin = maxMinSteps;
+    n.log = log;
+    n.step = step;
+    n.div = div;
+}
+
+//! Drop all cached divisions
+void ScaleDivCache::clear()
+{
+    entries_.clear();
 }
@@ -11,6 +11,7 @@
 #define PLOTMM_SCALEDIV_H
 
 #include <vector>
+#include <list>
 
 namespace PlotMM {
 
@@ -120,11 +121,42 @@ main()
 	double d_hBound;
 	double d_majStep;
 	bool d_log;
+	bool d_autoStep;
+	int d_maxMaj, d_maxMin;
 
 	std::vector<double> majMarks_;
 	std::vector<double> minMarks_;
     };
 
+    /*!
+     *  \brief A small LRU cache of scale divisions
+     *
+     *  Ranges recur often, e.g. when zooming back and forth or when an
+     *  autoscaled axis returns to a previous extent.  ScaleDivCache
+     *  remembers the divisions built for the last few parameter sets,
+     *  so these are copied instead of being built again.
+     */
+    class ScaleDivCache
+    {
+    public:
+	ScaleDivCache(unsigned int size = 8);
+
+	void rebuild(ScaleDiv &div, double x1, double x2,
+		     int maxMaj, int maxMin, bool log, double step = 0.0);
+	void clear();
+
+    private:
+	struct Entry
+	{
+	    double lo, hi, step;
+	    int maxMaj, maxMin;
+	    bool log;
+	    ScaleDiv div;
+	};
+	std::list<Entry> entries_;
+	unsigned int size_;
+    };
+
 }
 
 #endif
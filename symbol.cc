@@ -25,11 +25,28 @@ using namespace PlotMM;
 Symbol::Symbol(SymbolStyleID style, int size, int sizeb):
     size_(size),
     sizeB_(sizeb),
-    style_(style)
+    style_(style),
+    filled_(false)
 {
     paint_= Glib::RefPtr<Paint> (new Paint);
 }
 
+/*!
+  \brief Copy constructor
+
+  The copy gets a Paint of its own, so it can be changed without
+  affecting s.
+*/
+Symbol::Symbol(const Symbol &s):
+    PlotMM::ObjectBase(s),
+    paint_(new Paint(*s.paint_)),
+    size_(s.size_),
+    sizeB_(s.sizeB_),
+    style_(s.style_),
+    filled_(s.filled_)
+{
+}
+
 //! Destructor
 Symbol::~Symbol()
 {
@@ -66,6 +66,7 @@ namespace PlotMM {
     {
     public:
 	Symbol(SymbolStyleID st=SYMBOL_NONE, int size=1, int sizeb=-1);
+	Symbol(const Symbol &s);
 	virtual ~Symbol();
 
 	bool operator!=(const Symbol &) const;
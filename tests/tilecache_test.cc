@@ -0,0 +1,116 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+/* Checks that TileCache only hands the samples of a tile's columns
+ * to Curve::draw() for curves with ascending x values. */
+
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+
+#include "curve.h"
+#include "tilecache.h"
+
+using namespace PlotMM;
+
+//! A curve recording the clip and the index range of every draw()
+class RecordingCurve : public Curve
+{
+public:
+    struct Call
+    {
+	double x1, x2;
+	int from, to;
+    };
+
+    virtual void draw(const Cairo::RefPtr<Cairo::Context> &cr,
+		      const Glib::RefPtr<Gdk::Window> p,
+		      const DoubleIntMap &xMap, const DoubleIntMap &yMap,
+		      int from = 0, int to = -1)
+    {
+	Call c;
+	double y1, y2;
+	cr->get_clip_extents(c.x1, y1, c.x2, y2);
+	c.from= from;
+	c.to= to < 0 ? data_size() - 1 : to;
+	{
+	    std::lock_guard<std::mutex> lock(mutex_);
+	    calls.push_back(c);
+	}
+	Curve::draw(cr, p, xMap, yMap, from, to);
+    }
+
+    std::vector<Call> calls;
+
+private:
+    std::mutex mutex_;
+};
+
+static int failures= 0;
+
+static void check(bool ok, const char *what)
+{
+    if (ok) return;
+    fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+//! Draw n samples over a canvas of width pixels in tiles of tile pixels
+static void run(bool sorted, int n, int width, int tile)
+{
+    std::vector<double> x(n), y(n);
+    for (int i= 0; i < n; ++i) {
+	x[i]= sorted ? i : (i * 7919) % n;
+	y[i]= i % 17;
+    }
+    Glib::RefPtr<RecordingCurve> curve(new RecordingCurve);
+    curve->set_data(x, y);
+
+    TileCache cache;
+    cache.set_tile_size(tile);
+    std::vector<TileCache::Item> items(1);
+    items[0].curve= curve;
+    items[0].xMap= DoubleIntMap(0, width - 1, 0.0, n - 1.0);
+    items[0].yMap= DoubleIntMap(tile - 1, 0, 0.0, 16.0);
+    cache.update(items, width, tile);
+
+    Cairo::RefPtr<Cairo::ImageSurface> target=
+	Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, tile);
+    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(target);
+    check(cache.paint(cr) == (width + tile - 1) / tile, "all tiles drawn");
+    check(int(curve->calls.size()) == (width + tile - 1) / tile,
+	  "one draw per tile");
+
+    const double perPixel= double(n) / width;
+    for (unsigned int i= 0; i < curve->calls.size(); ++i) {
+	const RecordingCurve::Call &c= curve->calls[i];
+	if (!sorted) {
+	    check(c.from == 0 && c.to == n - 1, "unsorted curve drawn whole");
+	    continue;
+	}
+	// every sample within the tile's columns is drawn ...
+	const DoubleIntMap &m= items[0].xMap;
+	check(c.from <= 0 || m.transform(x[c.from]) < c.x1,
+	      "first sample of tile drawn");
+	check(c.to >= n - 1 || m.transform(x[c.to]) >= c.x2,
+	      "last sample of tile drawn");
+	// ... and not many more
+	check(c.to - c.from + 1 <= (tile + 2 * 8 + 2) * perPixel + 3,
+	      "samples outside the tile skipped");
+    }
+}
+
+int main()
+{
+    run(true, 100000, 1000, 100);
+    run(true, 50, 1000, 64);
+    run(false, 10000, 1000, 100);
+    if (failures) return 1;
+    printf("tilecache_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include "threadpool.h"
+
+using namespace PlotMM;
+
+static thread_local bool in_worker_= false;
+
+/*!
+  \brief Constructor
+  \param n number of worker threads.  If 0, one thread per hardware
+           thread is started.
+*/
+ThreadPool::ThreadPool(unsigned int n) :
+    stop_(false)
+{
+    if (n == 0)
+	n= std::thread::hardware_concurrency();
+    if (n == 0)
+	n= 1;
+    for (unsigned int i= 0; i < n; ++i)
+	workers_.push_back(std::thread(&ThreadPool::run_, this));
+}
+
+/*! Destructor
+ *
+ *  Tasks still in the queue are executed before the workers exit.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	stop_= true;
+    }
+    cond_.notify_all();
+    for (unsigned int i= 0; i < workers_.size(); ++i)
+	workers_[i].join();
+}
+
+//! Queue a task for execution on one of the workers
+void ThreadPool::push(const std::function<void()> &task)
+{
+    {
+	std::lock_guard<std::mutex> lock(mutex_);
+	queue_.push_back(task);
+    }
+    cond_.notify_one();
+}
+
+/*! Run f(0) ... f(n-1) on the workers and wait until all returned
+ *
+ *  If called from within a worker thread, the calls are made
+ *  sequentially in the calling thread so that nested use of the
+ *  pool cannot deadlock.
+ */
+void ThreadPool::parallel_for(int n, const std::function<void(int)> &f)
+{
+    if (n <= 0) return;
+    if (n == 1 || in_worker_) {
+	for (int i= 0; i < n; ++i)
+	    f(i);
+	return;
+    }
+
+    std::mutex doneMutex;
+    std::condition_variable doneCond;
+    int pending= n;
+
+    for (int i= 0; i < n; ++i) {
+	push([&, i]() {
+		f(i);
+		std::lock_guard<std::mutex> lock(doneMutex);
+		if (--pending == 0)
+		    doneCond.notify_one();
+	    });
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    while (pending > 0)
+	doneCond.wait(lock);
+}
+
+//! Return the pool shared by all plots
+ThreadPool &ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+//! Return true if the calling thread is a pool worker
+bool ThreadPool::in_worker()
+{
+    return in_worker_;
+}
+
+//! Worker loop
+void ThreadPool::run_()
+{
+    in_worker_= true;
+    for (;;) {
+	std::function<void()> task;
+	{
+	    std::unique_lock<std::mutex> lock(mutex_);
+	    while (!stop_ && queue_.empty())
+		cond_.wait(lock);
+	    if (queue_.empty())
+		return;
+	    task= queue_.front();
+	    queue_.pop_front();
+	}
+	task();
+    }
+}
@@ -0,0 +1,68 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_THREADPOOL_H
+#define PLOTMM_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace PlotMM {
+
+    /*! @brief A fixed set of worker threads executing queued tasks
+     *
+     *  The pool is used by the rendering code to spread independent
+     *  pieces of work (binning chunks, curves, tiles) over all
+     *  available cores.  Tasks must not touch any Gtk or Gdk object;
+     *  they may only work on plain memory or on Cairo image surfaces
+     *  that are not shared with other tasks.
+     *
+     *  Most code simply uses the pool returned by ThreadPool::global().
+     *
+     *  \par Example:
+     *  \verbatim
+     ThreadPool::global().parallel_for(nchunks, [&](int i) {
+	 process(chunk[i]);
+     });
+     \endverbatim
+     */
+    class ThreadPool
+    {
+    public:
+	ThreadPool(unsigned int n = 0);
+	~ThreadPool();
+
+	//! Return the number of worker threads
+	unsigned int size() const { return workers_.size(); }
+
+	void push(const std::function<void()> &task);
+	void parallel_for(int n, const std::function<void(int)> &f);
+
+	static ThreadPool &global();
+	static bool in_worker();
+
+    private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	void run_();
+
+	std::vector<std::thread> workers_;
+	std::deque<std::function<void()> > queue_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool stop_;
+    };
+
+}
+
+#endif
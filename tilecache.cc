@@ -0,0 +1,144 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#include "tilecache.h"
+#include "curve.h"
+#include "threadpool.h"
+#include "supplemental.h"
+
+using namespace PlotMM;
+
+//! Constructor
+TileCache::TileCache() :
+    tileSize_(256),
+    width_(0),
+    height_(0)
+{
+}
+
+/*! Set the edge length of a tile
+ *
+ *  Small tiles make partial exposes cheaper, large tiles reduce the
+ *  cost of walking every curve once per tile.
+ */
+void TileCache::set_tile_size(int n)
+{
+    n= MAX(16, n);
+    if (n == tileSize_) return;
+    tileSize_= n;
+    width_= height_= 0;
+    tiles_.clear();
+}
+
+/*! Set the curves and the canvas size
+ *
+ *  All tiles are invalidated if anything differs from the previous
+ *  call.  Nothing is drawn until paint().
+ */
+void TileCache::update(const std::vector<Item> &items, int width, int height)
+{
+    bool changed= items.size() != items_.size();
+    for (unsigned int i= 0; !changed && i < items.size(); ++i) {
+	changed= items[i].curve != items_[i].curve ||
+	    items[i].curve->serial() != serials_[i] ||
+	    items[i].xMap != items_[i].xMap ||
+	    items[i].yMap != items_[i].yMap;
+    }
+    if (changed) {
+	items_= items;
+	serials_.resize(items.size());
+	for (unsigned int i= 0; i < items.size(); ++i)
+	    serials_[i]= items[i].curve->serial();
+	invalidate();
+    }
+
+    if (width == width_ && height == height_) return;
+    width_= width;
+    height_= height;
+    tiles_.clear();
+    for (int y= 0; y < height_; y+= tileSize_) {
+	for (int x= 0; x < width_; x+= tileSize_) {
+	    Tile t;
+	    t.x= x;
+	    t.y= y;
+	    t.w= MIN(tileSize_, width_ - x);
+	    t.h= MIN(tileSize_, height_ - y);
+	    t.valid= false;
+	    tiles_.push_back(t);
+	}
+    }
+}
+
+/*! Paint the tiles within the clip of cr
+ *
+ *  Tiles which are out of date are drawn first, in parallel.
+ *
+ *  \return number of tiles drawn
+ */
+int TileCache::paint(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    double x1, y1, x2, y2;
+    cr->get_clip_extents(x1, y1, x2, y2);
+
+    std::vector<Tile *> exposed, dirty;
+    for (unsigned int i= 0; i < tiles_.size(); ++i) {
+	Tile &t= tiles_[i];
+	if (t.x >= x2 || t.x + t.w <= x1 || t.y >= y2 || t.y + t.h <= y1)
+	    continue;
+	exposed.push_back(&t);
+	if (!t.valid)
+	    dirty.push_back(&t);
+    }
+
+    ThreadPool::global().parallel_for(dirty.size(), [&](int k) {
+	    draw_(*dirty[k]);
+	});
+
+    cr->save();
+    for (unsigned int i= 0; i < exposed.size(); ++i) {
+	const Tile &t= *exposed[i];
+	cr->set_source(t.surface, t.x, t.y);
+	cr->rectangle(t.x, t.y, t.w, t.h);
+	cr->fill();
+    }
+    cr->restore();
+    return dirty.size();
+}
+
+//! Draw all curves into a tile
+void TileCache::draw_(Tile &t) const
+{
+    if (!t.surface)
+	t.surface= Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, t.w, t.h);
+    Cairo::RefPtr<Cairo::Context> cr= Cairo::Context::create(t.surface);
+    cr->save();
+    cr->set_operator(Cairo::OPERATOR_CLEAR);
+    cr->paint();
+    cr->restore();
+
+    cr->translate(-t.x, -t.y);
+    cr->rectangle(t.x, t.y, t.w, t.h);
+    cr->clip();
+    for (unsigned int i= 0; i < items_.size(); ++i) {
+	const Item &it= items_[i];
+	int from, to;
+	it.curve->index_range(it.xMap, t.x, t.x + t.w - 1, from, to);
+	if (to < from) continue;
+	it.curve->draw(cr, Glib::RefPtr<Gdk::Window>(), it.xMap, it.yMap,
+		       from, to);
+    }
+    t.surface->flush();
+    t.valid= true;
+}
+
+//! Redraw all tiles when they are painted next
+void TileCache::invalidate()
+{
+    for (unsigned int i= 0; i < tiles_.size(); ++i)
+	tiles_[i].valid= false;
+}
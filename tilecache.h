@@ -0,0 +1,79 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_TILECACHE_H
+#define PLOTMM_TILECACHE_H
+
+#include <vector>
+
+#include <glibmm/refptr.h>
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+
+#include "doubleintmap.h"
+
+namespace PlotMM {
+
+    class Curve;
+
+    /*! @brief The curves of a canvas drawn as a grid of cached tiles
+     *
+     *  The canvas is split into square tiles of tile_size() pixels.
+     *  Every tile is an image surface into which all curves are drawn
+     *  with a clip to the tile, so Cairo only rasterizes the part of a
+     *  curve within the tile.  For curves with ascending x values only
+     *  the samples within the columns of the tile are walked, see
+     *  Curve::index_range().  Tiles are drawn concurrently on the
+     *  ThreadPool; the curves must therefore allow
+     *  Curve::concurrent_draw() and must not be changed meanwhile.
+     *
+     *  paint() only draws the tiles within the clip of the context
+     *  which are out of date, so exposing part of the canvas redraws
+     *  only the tiles intersecting that part.  All tiles become out of
+     *  date if a curve, its serial or its maps change.
+     */
+    class TileCache
+    {
+    public:
+	//! A curve together with the maps it is drawn with
+	struct Item
+	{
+	    Glib::RefPtr<Curve> curve;
+	    DoubleIntMap xMap, yMap;
+	};
+
+	TileCache();
+
+	void set_tile_size(int n);
+	//! Return the edge length of a tile
+	int tile_size() const { return tileSize_; }
+
+	void update(const std::vector<Item> &items, int width, int height);
+	int paint(const Cairo::RefPtr<Cairo::Context> &cr);
+	void invalidate();
+
+    private:
+	struct Tile
+	{
+	    int x, y, w, h;
+	    bool valid;
+	    Cairo::RefPtr<Cairo::ImageSurface> surface;
+	};
+
+	void draw_(Tile &t) const;
+
+	int tileSize_;
+	int width_, height_;
+	std::vector<Item> items_;
+	std::vector<unsigned long> serials_;
+	std::vector<Tile> tiles_;
+    };
+
+}
+
+#endif
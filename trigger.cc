@@ -0,0 +1,242 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "doubleintmap.h"
+#include "trigger.h"
+
+using namespace PlotMM;
+
+// number of trigger positions remembered by TriggeredCurve
+static const unsigned int max_triggers = 64;
+
+//! Constructor
+Trigger::Trigger() :
+    level_(0.0),
+    slope_(TRIGGER_RISING),
+    holdoff_(0),
+    last_(-1)
+{
+}
+
+//! Set the number of samples ignored after a trigger
+void Trigger::set_holdoff(int n)
+{
+    holdoff_= MAX(0, n);
+}
+
+//! Forget the position of the last trigger
+void Trigger::reset()
+{
+    last_= -1;
+}
+
+/*! Find the first crossing of level() with the trigger slope
+ *
+ *  \param y sample values
+ *  \param from first index to test; y[from-1] must be valid
+ *  \param to end of the search (exclusive)
+ *  \return index of the sample after the crossing or -1
+ */
+int Trigger::find(const double *y, int from, int to) const
+{
+    const bool rising= slope_ == TRIGGER_RISING;
+    int i= MAX(from, 1);
+
+#ifdef __SSE2__
+    // test 8 sample pairs per iteration; the exact position is
+    // looked up by the scalar loop below
+    const __m128d l= _mm_set1_pd(level_);
+    for (; i + 8 <= to; i+= 8) {
+	__m128d m= _mm_setzero_pd();
+	for (int k= 0; k < 8; k+= 2) {
+	    const __m128d a= _mm_loadu_pd(y + i + k - 1);
+	    const __m128d b= _mm_loadu_pd(y + i + k);
+	    if (rising)
+		m= _mm_or_pd(m, _mm_and_pd(_mm_cmplt_pd(a, l),
+					   _mm_cmpge_pd(b, l)));
+	    else
+		m= _mm_or_pd(m, _mm_and_pd(_mm_cmpgt_pd(a, l),
+					   _mm_cmple_pd(b, l)));
+	}
+	if (_mm_movemask_pd(m))
+	    break;
+    }
+#endif
+
+    for (; i < to; ++i) {
+	if (rising ? (y[i-1] < level_ && y[i] >= level_) :
+	    (y[i-1] > level_ && y[i] <= level_))
+	    return i;
+    }
+    return -1;
+}
+
+/*! Collect all triggers in y[from] ... y[to-1]
+ *
+ *  \param base absolute position of y[0]
+ *  \param hits receives the absolute positions of the triggers
+ */
+void Trigger::scan(const double *y, int from, int to, long long base,
+		   std::vector<long long> &hits)
+{
+    int i= from;
+    if (last_ >= 0)
+	i= int(MAX((long long)i, last_ + holdoff_ + 1 - base));
+    while (i < to) {
+	i= find(y, i, to);
+	if (i < 0) break;
+	last_= base + i;
+	hits.push_back(last_);
+	i+= holdoff_ + 1;
+    }
+}
+
+/* ****************************************************************** */
+
+/*!
+  \brief Ctor
+  \param title title of the curve
+*/
+TriggeredCurve::TriggeredCurve(const Glib::ustring &title) :
+    Curve(title),
+    pre_(100),
+    post_(400),
+    scanned_(0),
+    seenDiscarded_(0)
+{
+}
+
+//! Copy the samples and the trigger positions found so far
+TriggeredCurve::TriggeredCurve(const TriggeredCurve &c) :
+    Curve(c),
+    trigger_(c.trigger_),
+    pre_(c.pre_),
+    post_(c.post_),
+    scanned_(c.scanned_),
+    seenDiscarded_(c.seenDiscarded_),
+    triggers_(c.triggers_)
+{
+}
+
+//! Destructor
+TriggeredCurve::~TriggeredCurve()
+{
+}
+
+//! Return a copy of the curve to be drawn by another thread
+Glib::RefPtr<Curve> TriggeredCurve::clone() const
+{
+    TriggeredCurve *c= new TriggeredCurve(*this);
+    c->detach_style_();
+    return Glib::RefPtr<Curve>(c);
+}
+
+/*! Set the window shown around a trigger
+ *
+ *  \param pre number of samples before the trigger
+ *  \param post number of samples after the trigger
+ */
+void TriggeredCurve::set_window(int pre, int post)
+{
+    pre_= MAX(0, pre);
+    post_= MAX(0, post);
+    curve_changed();
+}
+
+/*! Return the number of complete windows still in the data
+ */
+int TriggeredCurve::window_count() const
+{
+    int n= 0;
+    int from, to;
+    while (window(n, from, to))
+	++n;
+    return n;
+}
+
+/*! Return the index range of a window
+ *
+ *  \param k 0 for the latest complete window, 1 for the one before ...
+ *  \param from index of the first sample of the window
+ *  \param to index of the last sample of the window
+ *  \return false if there is no such window
+ */
+bool TriggeredCurve::window(int k, int &from, int &to) const
+{
+    const long long end= discarded() + data_size();
+    int n= 0;
+    std::deque<long long>::const_reverse_iterator t;
+    for (t= triggers_.rbegin(); t != triggers_.rend(); ++t) {
+	if (*t + post_ >= end) continue;        // not complete yet
+	if (*t - pre_ < discarded()) break;     // already dropped
+	if (n++ < k) continue;
+	from= int(*t - pre_ - discarded());
+	to= int(*t + post_ - discarded());
+	return true;
+    }
+    return false;
+}
+
+/*!
+  \brief Draw the latest complete window
+  \param painter Painter
+  \param xMap maps x-values relative to the trigger point into pixel
+         coordinates.
+  \param yMap maps y-values into pixel coordinates.
+  \param from,to ignored; the range is given by the window
+*/
+void TriggeredCurve::draw(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+    const DoubleIntMap &xMap, const DoubleIntMap &yMap, int from, int to)
+{
+    if (!window(0, from, to)) return;
+
+    const double t= x(from + pre_);
+    if (xMap.logarithmic()) {
+	Curve::draw(cr, painter, xMap, yMap, from, to);
+	return;
+    }
+    DoubleIntMap shifted(xMap.i1(), xMap.i2(), xMap.d1() + t, xMap.d2() + t);
+    Curve::draw(cr, painter, shifted, yMap, from, to);
+}
+
+/*! Scan new samples for triggers
+ *
+ *  If the data were replaced rather than appended or shortened at the
+ *  front, all trigger positions are forgotten.
+ */
+void TriggeredCurve::data_changed(int first)
+{
+    Curve::data_changed(first);
+    if (first == 0 && discarded() <= seenDiscarded_) {
+	scanned_= 0;
+	triggers_.clear();
+	trigger_.reset();
+    }
+    seenDiscarded_= discarded();
+    scan_();
+}
+
+//! Scan all samples not scanned before
+void TriggeredCurve::scan_()
+{
+    const int size= data_size();
+    const int from= int(MAX(scanned_ - discarded(), 1LL));
+    if (from >= size) return;
+
+    hits_.clear();
+    trigger_.scan(y_data(), from, size, discarded(), hits_);
+    for (unsigned int i= 0; i < hits_.size(); ++i)
+	triggers_.push_back(hits_[i]);
+    while (triggers_.size() > max_triggers)
+	triggers_.pop_front();
+    scanned_= discarded() + size;
+}
@@ -0,0 +1,122 @@
+/* -*- mode: C++ ; c-file-style: "stroustrup" -*- *****************************
+ * PlotMM Widget Library
+ * Copyright (C) 2004   Andy Thaller
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the LGPL
+ *****************************************************************************/
+
+#ifndef PLOTMM_TRIGGER_H
+#define PLOTMM_TRIGGER_H
+
+#include <vector>
+#include <deque>
+
+#include "curve.h"
+
+namespace PlotMM {
+
+    /*!
+      Trigger slopes.
+      \sa Trigger::set_slope
+    */
+    enum TriggerSlope
+    {
+	TRIGGER_RISING,
+	TRIGGER_FALLING
+    };
+
+    /*! @brief Scope-style edge trigger
+     *
+     *  A Trigger searches sample data for crossings of a level with
+     *  a given slope.  A rising edge is found at index i if
+     *  y[i-1] < level <= y[i], a falling edge if y[i-1] > level >= y[i].
+     *  After a trigger, the following holdoff() samples are ignored.
+     *
+     *  The search compares several samples per instruction where SSE2
+     *  is available, which keeps up with MS/s data rates.  Samples are
+     *  addressed by absolute positions so that the trigger state stays
+     *  valid while a streaming curve drops old samples.
+     */
+    class Trigger
+    {
+    public:
+	Trigger();
+
+	void set_level(double l) { level_= l; }
+	//! Return the trigger level
+	double level() const { return level_; }
+	void set_slope(TriggerSlope s) { slope_= s; }
+	//! Return the trigger slope
+	TriggerSlope slope() const { return slope_; }
+	void set_holdoff(int n);
+	//! Return the number of samples ignored after a trigger
+	int holdoff() const { return holdoff_; }
+
+	void reset();
+	int find(const double *y, int from, int to) const;
+	void scan(const double *y, int from, int to, long long base,
+		  std::vector<long long> &hits);
+
+    private:
+	double level_;
+	TriggerSlope slope_;
+	int holdoff_;
+	long long last_;
+    };
+
+    /*! @brief A streaming curve displayed around its trigger points
+     *
+     *  TriggeredCurve scans every block of samples added with
+     *  append_data() for trigger events.  draw() shows the window of
+     *  samples from pre() samples before to post() samples after the
+     *  latest trigger whose window is complete.  The x map is shifted
+     *  so that the trigger point appears at x = 0, and the window is
+     *  passed to Curve::draw() as an index range without copying.
+     *
+     *  Use set_max_size() to let the curve drop old samples.
+     */
+    class TriggeredCurve : public Curve
+    {
+    public:
+	TriggeredCurve(const Glib::ustring &title = "");
+	virtual ~TriggeredCurve();
+
+	//! Return the trigger used to find the windows
+	Trigger &trigger() { return trigger_; }
+
+	void set_window(int pre, int post);
+	//! Return the number of samples shown before the trigger
+	int pre() const { return pre_; }
+	//! Return the number of samples shown after the trigger
+	int post() const { return post_; }
+
+	int window_count() const;
+	bool window(int k, int &from, int &to) const;
+
+	virtual Glib::RefPtr<Curve> clone() const;
+
+	virtual void draw(const Cairo::RefPtr<Cairo::Context> &cr, const Glib::RefPtr<Gdk::Window> painter,
+			  const DoubleIntMap &xMap, const DoubleIntMap &yMap,
+			  int from = 0, int to = -1);
+
+    protected:
+	virtual void data_changed(int first);
+
+    private:
+	TriggeredCurve(const TriggeredCurve &);
+	const TriggeredCurve& operator= (const TriggeredCurve &);
+
+	void scan_();
+
+	Trigger trigger_;
+	int pre_, post_;
+	long long scanned_;
+	long long seenDiscarded_;
+	std::deque<long long> triggers_;
+	std::vector<long long> hits_;
+    };
+
+}
+
+#endif